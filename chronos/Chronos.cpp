@@ -1,5 +1,9 @@
 #include <algorithm>
 #include <utility>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include "Chronos.hpp"
 #include "Worker.hpp"
 
@@ -9,22 +13,70 @@ namespace chronos {
 
     using guard = std::lock_guard<std::mutex>;
 
-    Chronos::Chronos(app_duration duration, app_time max_time) :
+    Chronos::Chronos(app_duration duration, app_time max_time, worker_runtime runtime) :
         tick_duration(duration),
         clock_time(0),
         max_time_(max_time),
         last_tick_duration(0),
-        tick_start(std::chrono::steady_clock::now()) {}
+        tick_start(std::chrono::steady_clock::now()),
+        fiber_pool(runtime == worker_runtime::fibers ? &FiberPool::shared() : nullptr) {}
 
     void Chronos::run(workers_list workers) {
+#ifdef __linux__
+      cpu_set_t previous_cpus;
+      bool pinned = false;
+      if (cpu >= 0 && !pthread_getaffinity_np(pthread_self(), sizeof(previous_cpus), &previous_cpus)) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pinned = !pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+      }
+#endif
+      begin(std::move(workers));
+      loop();
+      end();
+#ifdef __linux__
+      if (pinned)
+        pthread_setaffinity_np(pthread_self(), sizeof(previous_cpus), &previous_cpus);
+#endif
+    }
+
+    /**
+     * Prepares the run and starts the workers
+     */
+    void Chronos::begin(workers_list workers) {
       workers_ = std::move(workers);
+      telemetry.workers.clear();
+      for (auto worker: workers_) {
+        telemetry.workers.push_back(std::make_shared<WorkerTelemetry>());
+        worker->telemetry = telemetry.workers.back();
+        worker->wait_policy = wait_policy;
+      }
+      async_tasks.clear();
+      for (std::size_t i = 0; i < workers_.size(); i++)
+        async_tasks.push_back(std::make_unique<ThreadsafeQueue<std::function<void()>>>());
+      async_pending.assign(workers_.size(), 0);
+      async_first = 0;
+      async_seq.assign(workers_.size(), 0);
+      replay_pos = 0;
+      replay_diverged = false;
+      if (journal_output)
+        journal.begin(*journal_output);
+      next_alarm = 1;
       start_workers();
       signal_start();
-      loop();
+    }
+
+    /**
+     * Finishes the run, releases the workers waiting for Chronos
+     */
+    void Chronos::end() {
       signal_finish();
-      process_async();
+      process_async(true);
       wake_workers(true);
       workers_.clear();
+      if (telemetry_output)
+        telemetry.dump(*telemetry_output);
     }
 
     [[maybe_unused]] void Chronos::wait(const workers_list& workers) {
@@ -44,22 +96,151 @@ namespace chronos {
     }
 
     void Chronos::loop() {
-      app_time next_alarm = 1;
-      while (still_running()) {
-        clock_time++;
-        tick_started();
-        if (next_alarm <= clock_time)
-          next_alarm = wake_workers();
-        process_async();
-        tick();
-        wait_next_tick();
+      while (begin_tick())
+        end_tick(wait_next_tick());
+    }
+
+    /**
+     * Starts a new tick (wakes the workers, processes the async tasks and calls @ref tick)
+     * @return false if Chronos should not be running any more (no tick started)
+     */
+    bool Chronos::begin_tick() {
+      if (!still_running())
+        return false;
+      clock_time++;
+      tick_started();
+      woken_count = 0;
+      if (next_alarm <= clock_time)
+        next_alarm = wake_workers();
+      telemetry.workers_woken.add(woken_count);
+      process_async();
+      tick();
+      return true;
+    }
+
+    /**
+     * Called after the current tick is over
+     * @param overrun some worker was still running at the end of the tick
+     */
+    void Chronos::end_tick(bool overrun) {
+      if (adaptive)
+        adapt_duration(overrun);
+    }
+
+    void Chronos::set_adaptive_duration(app_duration min_duration, app_duration max_duration, double idle_target) {
+      adaptive = true;
+      this->min_duration = min_duration;
+      this->max_duration = max_duration;
+      this->idle_target = idle_target;
+      tick_duration = std::clamp(tick_duration.load(), min_duration, max_duration);
+    }
+
+    /**
+     * Adjusts the tick duration after the end of a tick.
+     *
+     * An overrun grows the duration by a quarter. Otherwise the duration shrinks by at most a tenth, but not below
+     * the busy time of the tick enlarged by the idle target, so the controller settles where ticks are just long
+     * enough for the workers.
+     */
+    void Chronos::adapt_duration(bool overrun) {
+      app_duration duration = tick_duration;
+      if (overrun)
+        duration += duration / 4;
+      else {
+        auto busy = std::chrono::duration<double>(std::chrono::steady_clock::now() - tick_start);
+        auto wanted = std::chrono::duration_cast<app_duration>(busy / (1 - idle_target));
+        duration = std::max(duration - duration / 10, std::min(wanted, duration));
       }
+      tick_duration = std::clamp(duration, min_duration, max_duration);
     }
 
-    void Chronos::process_async() {
-      unsigned long items = async_tasks.size();
-      for (unsigned long i = 0; i < items; i++)
-        async_tasks.pop().value()();
+    void Chronos::set_journal_input(std::istream &i) {
+      if (!Journal::read(i, replay))
+        throw error("Not a Chronos journal");
+      replaying = true;
+    }
+
+    /**
+     * Processes the tasks waiting in the workers' queues (those pushed meanwhile wait for the next call).
+     *
+     * The queues are taken round robin, one task at a time, starting with a different worker in every tick.
+     * At most async_budget tasks of a single worker are processed unless `drain` is set.
+     *
+     * When replaying a journal, the tasks recorded for this tick are processed instead (in the recorded order).
+     * @param drain process all the waiting tasks regardless of async_budget
+     */
+    void Chronos::process_async(bool drain) {
+      //the final drain is journaled as the tick following the last one
+      app_time tick = drain ? clock_time + 1 : clock_time.load();
+      std::size_t n = async_tasks.size();
+      unsigned long items = 0;
+      for (std::size_t i = 0; i < n; i++)
+        items += async_tasks[i]->size();
+      telemetry.queue_depth.add(items);
+      unsigned long processed = 0;
+
+      while (replaying && replay_pos < replay.size() && replay[replay_pos].tick <= tick) {
+        const JournalEntry &entry = replay[replay_pos];
+        if (entry.worker >= n || entry.seq != async_seq[entry.worker] || !wait_for_async(entry.worker)) {
+          replaying = false;
+          replay_diverged = true;
+          break;
+        }
+        replay_pos++;
+        run_async(entry.worker, tick);
+        processed++;
+      }
+
+      if (!replaying || drain) {
+        for (std::size_t i = 0; i < n; i++) {
+          unsigned long size = async_tasks[i]->size();
+          async_pending[i] = (!drain && async_budget) ? std::min(size, async_budget) : size;
+        }
+        for (bool any = true; any;) {
+          any = false;
+          for (std::size_t k = 0; k < n; k++) {
+            std::size_t i = (async_first + k) % n;
+            if (async_pending[i]) {
+              async_pending[i]--;
+              run_async(i, tick);
+              processed++;
+              any = true;
+            }
+          }
+        }
+        if (n)
+          async_first = (async_first + 1) % n;
+      }
+      telemetry.async_processed.add(processed);
+    }
+
+    /**
+     * Processes the first task in the queue of worker `index` (and journals it)
+     */
+    void Chronos::run_async(std::size_t index, app_time tick) {
+      if (journal_output)
+        journal.write(*journal_output, {tick, static_cast<std::uint32_t>(index), async_seq[index]});
+      async_seq[index]++;
+      async_tasks[index]->pop().value()();
+    }
+
+    /**
+     * Waits until worker `index` submits a task (used when replaying)
+     * @return false if the worker finished or fell asleep without submitting it
+     */
+    bool Chronos::wait_for_async(std::size_t index) {
+      Worker *worker = workers_[index];
+      while (!async_tasks[index]->size()) {
+        bool asleep;
+        {
+          const guard lock(worker->alarm_handling);
+          asleep = worker->alarm != 0;
+        }
+        if (!worker->running || asleep)
+          return async_tasks[index]->size() > 0;
+        std::this_thread::yield();
+      }
+      return true;
     }
 
     /**
@@ -70,6 +251,7 @@ namespace chronos {
      */
     bool Chronos::still_running() {
       return (!max_time_ || (clock_time <= max_time_)) &&
+             (!max_elapsed.count() || (elapsed.load() <= max_elapsed)) &&
              std::any_of(workers_.begin(), workers_.end(), [](auto worker) { return (bool) worker->running; });
     }
 
@@ -79,13 +261,16 @@ namespace chronos {
      */
     app_time Chronos::wake_workers(bool wake_all) {
       app_time next_alarm = 0;
+      app_time_point now = std::chrono::steady_clock::now();
       for (auto worker: workers_) {
         const guard lock(worker->alarm_handling);
         if (worker->alarm) {
           if (wake_all || (worker->alarm <= clock_time)) {
             worker->alarm = 0;
             worker->working.lock();
-            worker->waker.unlock();
+            worker->woken_at = now;
+            woken_count++;
+            worker->resume();
             next_alarm = 1;
           }
           else if (!next_alarm || (worker->alarm < next_alarm))
@@ -102,7 +287,7 @@ namespace chronos {
      */
     void Chronos::start_workers() {
       for (auto worker: workers_)
-        worker->start();
+        worker->start(fiber_pool);
     }
 
     /**
@@ -116,17 +301,43 @@ namespace chronos {
      * if index == workers_.size() we have all the locks e.g. all the workers_ are sleeping
      *   we do not need to wait and can go on in the next tick
      * anyway always release all the acquired locks at the end
+     * (each lock is first polled according to wait_policy, see WaitPolicy)
+     * @return true if some worker was still running at the end of the tick
      */
-    void Chronos::wait_next_tick() {
-      int index;
-      app_time_point next_tick = tick_start + tick_duration;
-      for (index = 0; index < workers_.size(); index++) {
-        if (!workers_[index]->working.try_lock_until(next_tick))
+    bool Chronos::wait_next_tick() {
+      std::size_t locked;
+      app_time_point next_tick = tick_start + tick_duration.load();
+      for (locked = 0; locked < workers_.size(); locked++) {
+        std::timed_mutex &working = workers_[locked]->working;
+        if (!wait_policy.poll([&working]() { return working.try_lock(); }, next_tick) &&
+            !working.try_lock_until(next_tick))
+          break;
+      }
+      bool overrun = locked < workers_.size();
+      for (std::size_t index = 0; index < locked; index++) {
+        worker_unlock(static_cast<int>(index));
+      }
+      return overrun;
+    }
+
+    /**
+     * Non blocking variant of @ref wait_next_tick: the tick is over if all the workers_ are sleeping or its time
+     * has passed
+     * @param overrun set to true if some worker is still running
+     * @return bool
+     */
+    bool Chronos::tick_over(bool &overrun) {
+      bool timed_out = std::chrono::steady_clock::now() >= tick_start + tick_duration.load();
+      std::size_t locked;
+      for (locked = 0; locked < workers_.size(); locked++) {
+        if (!workers_[locked]->working.try_lock())
           break;
       }
-      for (index--; index >= 0; index--) {
-        worker_unlock(index);
+      overrun = locked < workers_.size();
+      for (std::size_t index = 0; index < locked; index++) {
+        worker_unlock(static_cast<int>(index));
       }
+      return !overrun || timed_out;
     }
 
     void Chronos::worker_unlock(int index) {
@@ -138,10 +349,12 @@ namespace chronos {
     }
 
     int Chronos::get_thread_index() {
+      Fiber *fiber = Fiber::current();
       std::thread::id cur_id = std::this_thread::get_id();
       int index;
       for (index = 0; index < workers_.size(); index++) {
-        if (workers_[index]->runner->get_id() == cur_id)
+        Worker *worker = workers_[index];
+        if (fiber ? worker->fiber == fiber : (worker->runner && worker->runner->get_id() == cur_id))
           return index;
       }
       throw error_unknown_thread();
@@ -151,6 +364,12 @@ namespace chronos {
       app_time_point now = std::chrono::steady_clock::now();
       last_tick_duration = now - tick_start;
       tick_start = now;
+      elapsed = elapsed.load() + tick_duration.load();
+      if (clock_time > 1) {
+        telemetry.tick_duration.add(last_tick_duration.count());
+        if (last_tick_duration > tick_duration.load())
+          telemetry.overrun_ticks++;
+      }
     }
 
     /** helper function used for debugging */
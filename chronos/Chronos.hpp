@@ -3,8 +3,13 @@
 
 #include <vector>
 #include <mutex>
+#include <memory>
 #include <future>
 #include "ThreadsafeQueue.hpp"
+#include "FiberPool.hpp"
+#include "Telemetry.hpp"
+#include "WaitPolicy.hpp"
+#include "Journal.hpp"
 
 /** @file */
 
@@ -14,6 +19,11 @@
 namespace chronos {
     class Worker;
 
+    class Executor;
+
+    template<typename T>
+    class Completion;
+
     /**
      * Base class for Chronos exceptions
      */
@@ -60,6 +70,14 @@ namespace chronos {
     /** list of workers_ */
     using workers_list = std::vector<Worker *>;
 
+    /** how the Workers' Worker::main are executed */
+    enum class worker_runtime {
+        /** every Worker has its own thread */
+        threads,
+        /** Workers run as fibers multiplexed on FiberPool::shared (sized to the number of cores) */
+        fibers
+    };
+
     /**
      * Main Chronos class. Orchestrates all its workers_ and handles inter process communication.
      *
@@ -69,6 +87,7 @@ namespace chronos {
      * Destruction may be done as soon as @ref run returns.
      */
     class Chronos {
+        friend Executor;
      private:
         std::atomic<app_time> clock_time;
         std::atomic<bool> finished = false;
@@ -76,12 +95,38 @@ namespace chronos {
         workers_list workers_;
         app_duration last_tick_duration;
         app_time_point tick_start;
-        app_duration tick_duration;
-        ThreadsafeQueue<std::function<void()>> async_tasks;
+        std::atomic<app_duration> tick_duration;
+        std::atomic<app_duration> elapsed{app_duration(0)};
+        app_duration max_elapsed{0};
+        bool adaptive = false;
+        app_duration min_duration{0};
+        app_duration max_duration{0};
+        double idle_target = 0;
+        //one queue per worker, drained round robin by process_async
+        std::vector<std::unique_ptr<ThreadsafeQueue<std::function<void()>>>> async_tasks;
+        std::vector<unsigned long> async_pending;
+        unsigned long async_budget = 0;
+        std::size_t async_first = 0;
+        std::vector<std::uint64_t> async_seq;
+        std::ostream *journal_output = nullptr;
+        Journal journal;
+        std::vector<JournalEntry> replay;
+        std::size_t replay_pos = 0;
+        bool replaying = false;
+        bool replay_diverged = false;
+        FiberPool *fiber_pool = nullptr;
+        Telemetry telemetry;
+        std::ostream *telemetry_output = nullptr;
+        unsigned long woken_count = 0;
+        WaitPolicy wait_policy;
+        int cpu = -1;
+        app_time next_alarm = 1;
 
         void start_workers();
 
-        void wait_next_tick();
+        bool wait_next_tick();
+
+        void adapt_duration(bool overrun);
 
         app_time wake_workers(bool wake_all = false);
 
@@ -89,11 +134,29 @@ namespace chronos {
 
         void loop();
 
+        void begin(workers_list workers);
+
+        bool begin_tick();
+
+        void end_tick(bool overrun);
+
+        bool tick_over(bool &overrun);
+
+        void end();
+
+        app_time_point tick_deadline() const {
+          return tick_start + tick_duration.load();
+        }
+
         void signal_finish();
 
         void signal_start();
 
-        void process_async();
+        void process_async(bool drain = false);
+
+        void run_async(std::size_t index, app_time tick);
+
+        bool wait_for_async(std::size_t index);
 
         void tick_started();
 
@@ -111,8 +174,10 @@ namespace chronos {
          *
          * @param duration  - duration of one tick
          * @param max_time  - maximum number of ticks to run
+         * @param runtime   - whether workers get their own threads or run as fibers on a shared pool
          */
-        explicit Chronos(app_duration duration, app_time max_time = 0);
+        explicit Chronos(app_duration duration, app_time max_time = 0,
+                         worker_runtime runtime = worker_runtime::threads);
 
         /**
          * Returns current global time (number of ticks since start)
@@ -150,9 +215,65 @@ namespace chronos {
          * @return app_duration
          */
         app_duration get_remaining_time() {
-          return tick_start + tick_duration - std::chrono::steady_clock::now();
+          return tick_start + tick_duration.load() - std::chrono::steady_clock::now();
         };
 
+        /**
+         * Returns duration of the current tick (constant unless @ref set_adaptive_duration was called)
+         *
+         * may be called by workers_
+         * @return app_duration
+         */
+        inline app_duration get_tick_duration() const {
+          return tick_duration;
+        }
+
+        /**
+         * Returns sum of durations of the ticks up to (and including) the current one. With a constant duration
+         * it equals get_time() * duration; with @ref set_adaptive_duration it is the time which should be used
+         * as the application time of the current tick.
+         *
+         * may be called by workers_
+         * @return app_duration
+         */
+        inline app_duration get_elapsed() const {
+          return elapsed;
+        }
+
+        /**
+         * Lets Chronos control the tick duration while running. After every tick the duration is increased
+         * if some worker was still working at its end (overrun) and decreased if all the workers finished
+         * before a fraction `idle_target` of the tick was left, so that ticks stay as short as the load allows.
+         * The duration passed to the constructor is the initial one.
+         *
+         * Must be called before @ref run.
+         * @param min_duration - lower bound of the tick duration
+         * @param max_duration - upper bound of the tick duration
+         * @param idle_target  - fraction of a tick which should stay unused
+         */
+        void set_adaptive_duration(app_duration min_duration, app_duration max_duration, double idle_target = 0.25);
+
+        /**
+         * Stops Chronos as soon as @ref get_elapsed exceeds `max_elapsed` (0 means no limit). Together with
+         * @ref set_adaptive_duration it replaces `max_time` of the constructor, as the number of ticks is not known.
+         *
+         * Must be called before @ref run.
+         * @param max_elapsed
+         */
+        [[maybe_unused]] inline void set_max_elapsed(app_duration max_elapsed) {
+          this->max_elapsed = max_elapsed;
+        }
+
+        /**
+         * Changes the maximal number of ticks set in the constructor (0 means no limit)
+         *
+         * Must be called before @ref run.
+         * @param max_time
+         */
+        [[maybe_unused]] inline void set_max_time(app_time max_time) {
+          max_time_ = max_time;
+        }
+
         /**
          * get last tick duration
          * @return app_duration
@@ -161,6 +282,87 @@ namespace chronos {
           return last_tick_duration;
         };
 
+        /**
+         * Returns the telemetry collected by @ref run (tick durations, async queue, wake ups, per worker latencies)
+         * @return Telemetry
+         */
+        inline const Telemetry &get_telemetry() const {
+          return telemetry;
+        }
+
+        /**
+         * if `o` is not null, the telemetry is written to it (as csv) at the end of @ref run
+         * @param o output stream or nullptr
+         */
+        [[maybe_unused]] inline void set_telemetry_output(std::ostream *o) {
+          telemetry_output = o;
+        }
+
+        /**
+         * Limits the number of tasks (passed to @ref async or @ref submit) of a single worker processed in one
+         * tick, the remaining ones wait for the next tick. Together with the round robin draining of the
+         * workers' queues it keeps the processing time of a tick bounded and fair when some worker floods
+         * Chronos with tasks.
+         *
+         * Must be called before @ref run.
+         * @param budget maximal number of tasks per worker and tick (0, the default, means no limit)
+         */
+        [[maybe_unused]] inline void set_async_budget(unsigned long budget) {
+          async_budget = budget;
+        }
+
+        /**
+         * if `o` is not null, every async task (of @ref async or @ref submit) processed during @ref run is
+         * recorded to `o` as a JournalEntry (tick, worker index, sequence number of the task within the worker)
+         * @param o binary output stream or nullptr
+         */
+        [[maybe_unused]] inline void set_journal_output(std::ostream *o) {
+          journal_output = o;
+        }
+
+        /**
+         * Replays a journal recorded by @ref set_journal_output: the async tasks are processed in the same ticks
+         * and in the same order as in the recorded run (Chronos waits for a task until its worker submits it),
+         * so a run with deterministic workers repeats exactly. Once the run diverges from the journal (a worker
+         * finishes or sleeps instead of submitting the expected task), the tasks are processed as usual and
+         * @ref get_replay_diverged returns true.
+         *
+         * Must be called before @ref run.
+         * @param i binary input stream
+         * throws chronos::error if `i` does not contain a journal
+         */
+        void set_journal_input(std::istream &i);
+
+        /**
+         * Returns true if the replayed run diverged from the journal (see @ref set_journal_input)
+         * @return bool
+         */
+        [[maybe_unused]] inline bool get_replay_diverged() const {
+          return replay_diverged;
+        }
+
+        /**
+         * Sets how Chronos waits for the workers at the end of a tick and how the workers (with
+         * worker_runtime::threads) wait in Worker::sleep_until
+         *
+         * Must be called before @ref run.
+         * @param policy
+         */
+        [[maybe_unused]] inline void set_wait_policy(const WaitPolicy &policy) {
+          wait_policy = policy;
+        }
+
+        /**
+         * Pins the thread calling @ref run to the core `cpu` for the time of the run (-1, the default, means no
+         * pinning). Ignored where thread affinity is not supported.
+         *
+         * Must be called before @ref run.
+         * @param cpu index of the core
+         */
+        [[maybe_unused]] inline void set_cpu(int cpu) {
+          this->cpu = cpu;
+        }
+
         /**
          * starts the main loop
          */
@@ -182,6 +384,9 @@ namespace chronos {
         /**
          * passed Functor (probably lambda) is marked for async execution by Chronos
          * async blocks calling thread until the task is finished
+         *
+         * every worker has its own queue of tasks, at the beginning of a tick the queues are drained round robin
+         * (see @ref set_async_budget)
          * returns same type as the Functor
          *
          * @tparam Functor
@@ -200,8 +405,25 @@ namespace chronos {
           std::future<ret> future = task.get_future();
           auto t = std::make_shared<task_t>(std::move(task));
           int index = get_thread_index();
-
-          async_tasks.push_and_action([t, this, index]() {
+          app_time_point blocked_since = std::chrono::steady_clock::now();
+          WorkerTelemetry &worker_telemetry = *telemetry.workers[index];
+
+          if (Fiber *fiber = Fiber::current()) {
+            //the fiber gives up its pool thread and is woken when the task is done
+            async_tasks[index]->push_and_action([t, this, index, fiber]() {
+                                            worker_lock(index);
+                                            (*t)();
+                                            fiber->wake();
+                                        }, [this, index]() {
+                                            worker_unlock(index);
+                                        }
+            );
+            fiber->suspend();
+            worker_telemetry.async_blocked.add((std::chrono::steady_clock::now() - blocked_since).count());
+            return future.get();
+          }
+
+          async_tasks[index]->push_and_action([t, this, index]() {
                                           worker_lock(index);
                                           (*t)();
                                       }, [this, index]() {
@@ -210,8 +432,75 @@ namespace chronos {
           );
 
           ret retval = future.get();
+          worker_telemetry.async_blocked.add((std::chrono::steady_clock::now() - blocked_since).count());
           return retval;
         }
+
+        /**
+         * passed Functor is marked for async execution by Chronos like with @ref async, but the calling thread
+         * is not blocked. Tasks are executed in the order they were submitted (by @ref submit or @ref async), so
+         * a worker may submit several tasks within one tick and collect their results later.
+         *
+         * @tparam Functor
+         * @param functor function returning ret type
+         * @return Completion<ret> handle of the result
+         */
+        template<typename Functor>
+        auto submit(Functor functor) {
+          using ret = decltype(functor());
+          using task_t = std::packaged_task<ret()>;
+
+          if (finished)
+            throw error_already_finished();
+
+          auto t = std::make_shared<task_t>(functor);
+          Completion<ret> completion(t->get_future(), this);
+          async_tasks[get_thread_index()]->push([t]() {
+              (*t)();
+          });
+          return completion;
+        }
+    };
+
+    /**
+     * Handle of a result of a task passed to Chronos::submit
+     * @tparam T type of the result
+     */
+    template<typename T>
+    class Completion {
+     private:
+        std::future<T> future_;
+        Chronos *chronos_;
+
+     public:
+        /**
+         * constructor (used by Chronos::submit)
+         * @param future future of the task
+         * @param chronos Chronos executing the task (may be nullptr if `future` is ready)
+         */
+        Completion(std::future<T> future, Chronos *chronos) : future_(std::move(future)), chronos_(chronos) {}
+
+        /**
+         * returns true if the task has been executed
+         * @return bool
+         */
+        bool ready() const {
+          return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        /**
+         * Returns the result of the task, may be called only once. If the task has not been executed yet, the
+         * caller is blocked the same way as by Chronos::async (the Worker is considered sleeping meanwhile).
+         *
+         * throws `chronos::error_already_finished` if the task was not executed and Chronos already finished
+         * @return T
+         */
+        T get() {
+          if (!ready())
+            //tasks are executed in order, so the task is done once this empty one is
+            chronos_->async([]() { return true; });
+          return future_.get();
+        }
     };
 
 }
@@ -0,0 +1,146 @@
+#ifndef CHRONOS_EXECUTOR_HPP
+#define CHRONOS_EXECUTOR_HPP
+
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Chronos.hpp"
+#include "FiberPool.hpp"
+
+/** @file
+ * definition of Executor */
+
+namespace chronos {
+
+    /**
+     * Runs several Chronos clocks at once on shared resources.
+     *
+     * The Workers of all the clocks run as fibers on one FiberPool (regardless of the worker_runtime the Chronos
+     * was constructed with) and a single scheduler thread interleaves the ticks of the clocks: whenever a tick of
+     * some clock is over (all its Workers sleep or its duration has passed) the scheduler starts the next tick of
+     * that clock, so every clock keeps its own tick semantics.
+     *
+     * @ref run is called instead of Chronos::run, typically from one thread per clock.
+     */
+    class Executor {
+     private:
+        struct Clock {
+            Chronos *chronos;
+            bool ticking = false;
+            bool done = false;
+        };
+
+        FiberPool pool_;
+        app_duration poll_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::condition_variable done_cv_;
+        std::vector<Clock *> pending_;
+        bool stopping_ = false;
+        std::thread scheduler_;
+
+        void schedule() {
+          std::vector<Clock *> active;
+          for (;;) {
+            {
+              std::unique_lock<std::mutex> lock(mutex_);
+              if (active.empty())
+                cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+              if (active.empty() && pending_.empty())
+                return;
+              for (auto clock: pending_) {
+                clock->ticking = clock->chronos->begin_tick();
+                active.push_back(clock);
+              }
+              pending_.clear();
+            }
+
+            bool progressed = false;
+            app_time_point deadline = app_time_point::max();
+            for (auto it = active.begin(); it != active.end();) {
+              Clock *clock = *it;
+              Chronos &chronos = *clock->chronos;
+              bool overrun;
+              if (clock->ticking && chronos.tick_over(overrun)) {
+                chronos.end_tick(overrun);
+                clock->ticking = chronos.begin_tick();
+                progressed = true;
+              }
+              if (!clock->ticking) {
+                {
+                  const guard lock(mutex_);
+                  clock->done = true;
+                }
+                done_cv_.notify_all();
+                it = active.erase(it);
+                continue;
+              }
+              deadline = std::min(deadline, chronos.tick_deadline());
+              ++it;
+            }
+
+            //nothing happened, wait a bit (the Workers may fall asleep before the end of their ticks)
+            if (!progressed && !active.empty())
+              std::this_thread::sleep_until(std::min(deadline, std::chrono::steady_clock::now() + poll_));
+          }
+        }
+
+     public:
+        /**
+         * Starts the pool and the scheduler
+         * @param threads number of threads of the pool (0 means the number of cores)
+         * @param poll    how often the scheduler checks for Workers which finished their ticks early
+         */
+        explicit Executor(unsigned threads = 0, app_duration poll = std::chrono::microseconds(50)) :
+            pool_(threads), poll_(poll), scheduler_(&Executor::schedule, this) {}
+
+        Executor(const Executor &) = delete;
+
+        Executor &operator=(const Executor &) = delete;
+
+        /**
+         * Joins the scheduler, the clocks being run are finished first
+         */
+        ~Executor() {
+          {
+            const guard lock(mutex_);
+            stopping_ = true;
+          }
+          cv_.notify_all();
+          scheduler_.join();
+        }
+
+        /**
+         * Runs `chronos` with `workers` the way Chronos::run does and returns after it finished. May be called
+         * concurrently for different clocks.
+         * @param chronos
+         * @param workers
+         */
+        void run(Chronos &chronos, workers_list workers) {
+          chronos.fiber_pool = &pool_;
+          chronos.begin(std::move(workers));
+          Clock clock{&chronos};
+          {
+            const guard lock(mutex_);
+            pending_.push_back(&clock);
+          }
+          cv_.notify_all();
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait(lock, [&clock]() { return clock.done; });
+          }
+          chronos.end();
+        }
+
+        /**
+         * @return number of threads executing the Workers
+         */
+        unsigned size() const {
+          return pool_.size();
+        }
+    };
+}
+
+#endif //CHRONOS_EXECUTOR_HPP
@@ -0,0 +1,249 @@
+#ifndef CHRONOS_FIBERPOOL_HPP
+#define CHRONOS_FIBERPOOL_HPP
+
+#include <ucontext.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+/** @file
+ * definition of Fiber and FiberPool */
+
+namespace chronos {
+
+    class FiberPool;
+
+    /**
+     * Stackful coroutine executed by a FiberPool.
+     *
+     * The body runs on its own stack and may give up its pool thread by calling @ref suspend. A suspended fiber
+     * continues (possibly on another thread of the pool) after somebody calls @ref wake.
+     * A wake arriving before the fiber actually left its thread is remembered, so no wake-up is ever lost.
+     */
+    class Fiber {
+        friend FiberPool;
+     private:
+        ucontext_t context_{};
+        ucontext_t *return_context_ = nullptr;
+        std::unique_ptr<char[]> stack_;
+        std::function<void()> body_;
+        FiberPool &pool_;
+
+        //guards parked_, wake_pending_ and done_
+        std::mutex state_mutex_;
+        std::condition_variable done_cv_;
+        //a new fiber is parked until its first wake
+        bool parked_ = true;
+        bool wake_pending_ = false;
+        //body has returned (set from inside the fiber)
+        bool returned_ = false;
+        //fiber left its stack for good (set by the pool thread)
+        bool done_ = false;
+
+        static Fiber *&current_slot() {
+          static thread_local Fiber *current = nullptr;
+          return current;
+        }
+
+        static void trampoline() {
+          Fiber *self = current_slot();
+          try {
+            self->body_();
+          }
+          catch (...) {
+            // body is expected to handle its exceptions, they must not cross the context switch
+          }
+          self->returned_ = true;
+          swapcontext(&self->context_, self->return_context_);
+        }
+
+     public:
+        /**
+         * Prepares the fiber, it is started by the first @ref wake
+         * @param pool pool executing the fiber
+         * @param body function run on the fiber stack
+         * @param stack_size size of the stack in bytes
+         */
+        Fiber(FiberPool &pool, std::function<void()> body, std::size_t stack_size) :
+            stack_(new char[stack_size]),
+            body_(std::move(body)),
+            pool_(pool) {
+          getcontext(&context_);
+          context_.uc_stack.ss_sp = stack_.get();
+          context_.uc_stack.ss_size = stack_size;
+          context_.uc_link = nullptr;
+          makecontext(&context_, &Fiber::trampoline, 0);
+        }
+
+        Fiber(const Fiber &) = delete;
+
+        Fiber &operator=(const Fiber &) = delete;
+
+        /**
+         * Returns the fiber running on the calling thread or nullptr if called outside of any fiber
+         * @return Fiber*
+         */
+        static Fiber *current() {
+          return current_slot();
+        }
+
+        /**
+         * Gives up the pool thread until @ref wake is called. Must be called from inside the fiber.
+         */
+        void suspend() {
+          swapcontext(&context_, return_context_);
+        }
+
+        /**
+         * Makes the suspended fiber runnable again. May be called from any thread.
+         */
+        inline void wake();
+
+        /**
+         * Blocks the caller until the body of the fiber returns. Must not be called from a fiber of the same pool.
+         */
+        void join() {
+          std::unique_lock<std::mutex> lock(state_mutex_);
+          done_cv_.wait(lock, [this]() { return done_; });
+        }
+    };
+
+    /**
+     * Small pool of threads multiplexing fibers.
+     *
+     * A fiber occupies a pool thread until it calls Fiber::suspend or returns, so bodies should not block for a long
+     * time in system calls.
+     */
+    class FiberPool {
+        friend Fiber;
+     private:
+        std::vector<std::thread> threads_;
+        std::deque<Fiber *> ready_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        std::size_t stack_size_;
+
+        void thread_main() {
+          for (;;) {
+            Fiber *fiber;
+            {
+              std::unique_lock<std::mutex> lock(mutex_);
+              cv_.wait(lock, [this]() { return stopping_ || !ready_.empty(); });
+              if (ready_.empty())
+                return;
+              fiber = ready_.front();
+              ready_.pop_front();
+            }
+            resume(fiber);
+          }
+        }
+
+        void resume(Fiber *fiber) {
+          ucontext_t here;
+          fiber->return_context_ = &here;
+          Fiber::current_slot() = fiber;
+          swapcontext(&here, &fiber->context_);
+          Fiber::current_slot() = nullptr;
+
+          std::lock_guard<std::mutex> lock(fiber->state_mutex_);
+          if (fiber->returned_) {
+            fiber->done_ = true;
+            fiber->done_cv_.notify_all();
+          }
+          else if (fiber->wake_pending_) {
+            fiber->wake_pending_ = false;
+            schedule(fiber);
+          }
+          else
+            fiber->parked_ = true;
+        }
+
+     public:
+        /** default stack size of fibers created for workers */
+        static constexpr std::size_t default_stack_size = 1 << 20;
+
+        /**
+         * Starts the pool threads
+         * @param threads number of threads (0 means number of cores)
+         * @param stack_size stack size of fibers created for workers
+         */
+        explicit FiberPool(unsigned threads = 0, std::size_t stack_size = default_stack_size) :
+            stack_size_(stack_size) {
+          if (!threads)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+          for (unsigned i = 0; i < threads; i++)
+            threads_.emplace_back(&FiberPool::thread_main, this);
+        }
+
+        FiberPool(const FiberPool &) = delete;
+
+        FiberPool &operator=(const FiberPool &) = delete;
+
+        /**
+         * Joins the pool threads; all the fibers must have finished
+         */
+        ~FiberPool() {
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+          }
+          cv_.notify_all();
+          for (auto &thread: threads_)
+            thread.join();
+        }
+
+        /**
+         * Process wide pool sized to the core count. Never destroyed, so that fibers which did not finish
+         * (as threads of Workers which did not finish) cannot block the exit of the application.
+         * @return FiberPool&
+         */
+        static FiberPool &shared() {
+          static FiberPool *pool = new FiberPool();
+          return *pool;
+        }
+
+        /**
+         * Puts a runnable fiber into the ready queue
+         * @param fiber
+         */
+        void schedule(Fiber *fiber) {
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(fiber);
+          }
+          cv_.notify_one();
+        }
+
+        /**
+         * @return number of pool threads
+         */
+        unsigned size() const {
+          return threads_.size();
+        }
+
+        /**
+         * @return stack size of fibers created for workers
+         */
+        std::size_t stack_size() const {
+          return stack_size_;
+        }
+    };
+
+    inline void Fiber::wake() {
+      std::lock_guard<std::mutex> lock(state_mutex_);
+      if (parked_) {
+        parked_ = false;
+        pool_.schedule(this);
+      }
+      else
+        wake_pending_ = true;
+    }
+}
+
+#endif //CHRONOS_FIBERPOOL_HPP
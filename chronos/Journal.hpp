@@ -0,0 +1,109 @@
+#ifndef CHRONOS_JOURNAL_HPP
+#define CHRONOS_JOURNAL_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/** @file
+ * definition of Journal */
+
+namespace chronos {
+
+    /**
+     * One async task processed by Chronos
+     */
+    struct JournalEntry {
+        /** tick in which the task was processed (ticks after the last one mean the final drain) */
+        std::uint64_t tick;
+        /** index of the Worker which submitted the task (in the list passed to Chronos::run) */
+        std::uint32_t worker;
+        /** number of tasks of the same Worker processed before */
+        std::uint64_t seq;
+    };
+
+    /**
+     * Binary journal of the async tasks processed by Chronos, see Chronos::set_journal_output
+     *
+     * The stream starts with the magic "CHRJ" followed by a version byte, then every entry is written as three
+     * LEB128 varints: tick difference from the previous entry, worker and seq.
+     */
+    class Journal {
+     private:
+        static constexpr char magic[4] = {'C', 'H', 'R', 'J'};
+        static constexpr char version = 1;
+        std::uint64_t last_tick_ = 0;
+
+        static void write_varint(std::ostream &o, std::uint64_t value) {
+          do {
+            unsigned char byte = value & 0x7f;
+            value >>= 7;
+            if (value)
+              byte |= 0x80;
+            o.put(static_cast<char>(byte));
+          } while (value);
+        }
+
+        static bool read_varint(std::istream &i, std::uint64_t &value) {
+          value = 0;
+          for (int shift = 0; shift < 64; shift += 7) {
+            int byte = i.get();
+            if (byte == std::char_traits<char>::eof())
+              return false;
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+              return true;
+          }
+          return false;
+        }
+
+     public:
+        /**
+         * writes the header
+         * @param o output stream (binary)
+         */
+        void begin(std::ostream &o) {
+          o.write(magic, sizeof(magic));
+          o.put(version);
+          last_tick_ = 0;
+        }
+
+        /**
+         * writes one entry, entries have to be written in the order of ticks
+         * @param o output stream
+         * @param entry
+         */
+        void write(std::ostream &o, const JournalEntry &entry) {
+          write_varint(o, entry.tick - last_tick_);
+          write_varint(o, entry.worker);
+          write_varint(o, entry.seq);
+          last_tick_ = entry.tick;
+        }
+
+        /**
+         * reads a whole journal
+         * @param i input stream (binary)
+         * @param entries filled by the entries in the order they were written
+         * @return false if the stream is not a journal
+         */
+        static bool read(std::istream &i, std::vector<JournalEntry> &entries) {
+          char header[sizeof(magic) + 1];
+          if (!i.read(header, sizeof(header)) || std::string(header, sizeof(magic)) != std::string(magic, sizeof(magic))
+              || header[sizeof(magic)] != version)
+            return false;
+          entries.clear();
+          std::uint64_t tick = 0, delta, worker, seq;
+          while (read_varint(i, delta)) {
+            if (!read_varint(i, worker) || !read_varint(i, seq))
+              return false;
+            tick += delta;
+            entries.push_back({tick, static_cast<std::uint32_t>(worker), seq});
+          }
+          return true;
+        }
+    };
+}
+
+#endif //CHRONOS_JOURNAL_HPP
@@ -0,0 +1,148 @@
+#ifndef CHRONOS_TELEMETRY_HPP
+#define CHRONOS_TELEMETRY_HPP
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+/** @file
+ * definition of Histogram and Telemetry */
+
+namespace chronos {
+
+    /**
+     * Histogram with power-of-two buckets.
+     *
+     * Adding a value costs a few relaxed atomic operations, so it may be filled by one thread while another one
+     * reads it. Quantiles are approximate (upper bound of the bucket containing the quantile).
+     */
+    class Histogram {
+     private:
+        static constexpr int buckets_count = 65;
+        std::array<std::atomic<std::uint64_t>, buckets_count> buckets_{};
+        std::atomic<std::uint64_t> count_{0};
+        std::atomic<std::uint64_t> sum_{0};
+        std::atomic<std::uint64_t> max_{0};
+
+        static int bucket_of(std::uint64_t value) {
+          int bucket = 0;
+          while (value) {
+            value >>= 1;
+            bucket++;
+          }
+          return bucket;
+        }
+
+     public:
+        /**
+         * adds a sample
+         * @param value
+         */
+        void add(std::uint64_t value) {
+          buckets_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+          count_.fetch_add(1, std::memory_order_relaxed);
+          sum_.fetch_add(value, std::memory_order_relaxed);
+          std::uint64_t max = max_.load(std::memory_order_relaxed);
+          while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed));
+        }
+
+        /** @return number of samples */
+        std::uint64_t count() const {
+          return count_.load(std::memory_order_relaxed);
+        }
+
+        /** @return mean of samples (0 if empty) */
+        double mean() const {
+          std::uint64_t n = count();
+          return n ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / n : 0;
+        }
+
+        /** @return maximal sample */
+        std::uint64_t max() const {
+          return max_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * approximate quantile
+         * @param q level in [0,1]
+         * @return upper bound of the bucket in which the quantile lies
+         */
+        std::uint64_t quantile(double q) const {
+          std::uint64_t n = count();
+          if (!n)
+            return 0;
+          std::uint64_t rank = static_cast<std::uint64_t>(q * (n - 1)) + 1;
+          std::uint64_t seen = 0;
+          for (int bucket = 0; bucket < buckets_count; bucket++) {
+            seen += buckets_[bucket].load(std::memory_order_relaxed);
+            if (seen >= rank)
+              return bucket < 64 ? std::min(max(), (std::uint64_t(1) << bucket) - 1) : max();
+          }
+          return max();
+        }
+
+        /**
+         * writes one csv line: name,count,mean,p50,p90,p99,max
+         * @param o output stream
+         * @param name first column
+         */
+        void dump(std::ostream &o, const std::string &name) const {
+          o << name << "," << count() << "," << mean() << "," << quantile(0.5) << "," << quantile(0.9) << ","
+            << quantile(0.99) << "," << max() << "\n";
+        }
+    };
+
+    /**
+     * Telemetry collected by a Worker (filled by the worker itself, shared by the Worker and Telemetry so that
+     * a worker outliving its Chronos does not write to freed memory)
+     */
+    struct WorkerTelemetry {
+        /** time between Chronos waking the worker and the worker running again (in app_duration units) */
+        Histogram wake_latency;
+        /** time the worker spent blocked in Chronos::async (in app_duration units) */
+        Histogram async_blocked;
+    };
+
+    /**
+     * Tick level telemetry of a Chronos run, see Chronos::get_telemetry
+     */
+    struct Telemetry {
+        /** wall duration of ticks (in app_duration units) */
+        Histogram tick_duration;
+        /** number of async tasks processed in a tick */
+        Histogram async_processed;
+        /** number of async tasks waiting at the start of their processing */
+        Histogram queue_depth;
+        /** number of workers woken in a tick */
+        Histogram workers_woken;
+        /** number of ticks taking longer than the tick duration */
+        std::atomic<std::uint64_t> overrun_ticks{0};
+        /** per worker telemetry (by index in the list passed to Chronos::run) */
+        std::vector<std::shared_ptr<WorkerTelemetry>> workers;
+
+        /**
+         * writes the telemetry as csv
+         * @param o output stream
+         */
+        void dump(std::ostream &o) const {
+          o << "metric,count,mean,p50,p90,p99,max\n";
+          tick_duration.dump(o, "tick_duration");
+          async_processed.dump(o, "async_processed");
+          queue_depth.dump(o, "queue_depth");
+          workers_woken.dump(o, "workers_woken");
+          o << "overrun_ticks," << overrun_ticks << ",,,,,\n";
+          for (std::size_t i = 0; i < workers.size(); i++) {
+            workers[i]->wake_latency.dump(o, "worker" + std::to_string(i) + "_wake_latency");
+            workers[i]->async_blocked.dump(o, "worker" + std::to_string(i) + "_async_blocked");
+          }
+        }
+    };
+}
+
+#endif //CHRONOS_TELEMETRY_HPP
@@ -66,6 +66,15 @@ class ThreadsafeQueue {
       return tmp;
     }
 
+    /**
+     * Pushes an element into the queue
+     * @param item element to push into the queue
+     */
+    void push(const T &item) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push(item);
+    }
+
     /**
      * Pushes an element into the queue and (atomically) calls the `action` callback
      * @param item element to push into the queue
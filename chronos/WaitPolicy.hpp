@@ -0,0 +1,68 @@
+#ifndef CHRONOS_WAITPOLICY_HPP
+#define CHRONOS_WAITPOLICY_HPP
+
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/** @file
+ * definition of WaitPolicy */
+
+namespace chronos {
+
+    /**
+     * How Chronos and its Workers wait for each other.
+     *
+     * Before blocking in the kernel (parking), the waiting thread polls for `spin` iterations (with a pause
+     * instruction between polls) and then for `yield` iterations (giving up its time slice between polls).
+     * With the defaults (both zero) the threads park immediately. Spinning cuts the wake-up latency to well below
+     * a microsecond, but occupies a core, so it makes sense only with dedicated cores (see Chronos::set_cpu).
+     */
+    struct WaitPolicy {
+        /** number of polls with a pause instruction in between */
+        unsigned spin = 0;
+        /** number of polls with std::this_thread::yield in between (after spinning) */
+        unsigned yield = 0;
+
+        /** hints the processor that the thread is spinning */
+        static inline void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+          _mm_pause();
+#elif defined(__aarch64__)
+          asm volatile("yield");
+#endif
+        }
+
+        /**
+         * Polls `ready` according to the policy, stops early at `deadline`
+         * @tparam Ready callable returning bool
+         * @param ready polled condition (e.g. try_lock of a mutex)
+         * @param deadline time after which polling is pointless
+         * @return true if `ready` returned true, false if the caller should park
+         */
+        template<typename Ready>
+        bool poll(Ready ready, std::chrono::steady_clock::time_point deadline =
+                                  std::chrono::steady_clock::time_point::max()) const {
+          for (unsigned i = 0; i < spin; i++) {
+            if (ready())
+              return true;
+            if ((i & 63) == 63 && std::chrono::steady_clock::now() >= deadline)
+              return false;
+            pause();
+          }
+          for (unsigned i = 0; i < yield; i++) {
+            if (ready())
+              return true;
+            if (std::chrono::steady_clock::now() >= deadline)
+              return false;
+            std::this_thread::yield();
+          }
+          return false;
+        }
+    };
+}
+
+#endif //CHRONOS_WAITPOLICY_HPP
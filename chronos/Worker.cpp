@@ -14,6 +14,16 @@ namespace chronos {
         alarm_par = 1;
       if (finished)
         return;
+      if (fiber) {
+        {
+          const guard lock(alarm_handling);
+          alarm = alarm_par;
+        }
+        working.unlock(); //we stop working (locked again by Chronos when he wakes us back)
+        fiber->suspend(); //gives the pool thread to other fibers
+        record_wake_latency();
+        return;
+      }
       {
         const guard lock(alarm_handling);
         waker.lock();
@@ -21,22 +31,48 @@ namespace chronos {
       }
 
       working.unlock(); //we stop working (locked again by Chronos when he wakes us back)
-      waker.lock();     //this will block
+      if (!wait_policy.poll([this]() { return waker.try_lock(); }))
+        waker.lock();   //this will block
       waker.unlock();   //ready for next round
+      record_wake_latency();
+    }
+
+    void Worker::record_wake_latency() {
+      if (telemetry)
+        telemetry->wake_latency.add((std::chrono::steady_clock::now() - woken_at).count());
     }
 
     /**
-     * Start thread for this worker
+     * Wakes the worker sleeping in sleep_until
+     * called by Chronos in Chronos::wake_workers
+     */
+    void Worker::resume() {
+      if (fiber)
+        fiber->wake();
+      else
+        waker.unlock();
+    }
+
+    /**
+     * Start thread (or fiber on `pool` if given) for this worker
      * called by Chronos in Chronos::start_workers
      */
-    void Worker::start() {
+    void Worker::start(FiberPool *pool) {
       assert(!running); //same worker used multiple times?
       assert(!runner);
+      assert(!fiber);
       running = true;
       finished = false;
-      working.lock();
       alarm_handling.lock();
-      runner = new std::thread(&Worker::entry_point, this);
+      if (pool) {
+        //the fiber starts like a worker sleeping until the first tick (Chronos locks working when waking it)
+        alarm = 1;
+        fiber = new Fiber(*pool, [this]() { entry_point(); }, pool->stack_size());
+      }
+      else {
+        working.lock();
+        runner = new std::thread(&Worker::entry_point, this);
+      }
     }
 
     void Worker::wait() {
@@ -45,6 +81,11 @@ namespace chronos {
         delete runner;
         runner = nullptr;
       }
+      if (fiber) {
+        fiber->join();
+        delete fiber;
+        fiber = nullptr;
+      }
     }
 
     void Worker::entry_point() {
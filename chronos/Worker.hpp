@@ -35,12 +35,25 @@ namespace chronos {
         //this Worker has running working thread
         std::atomic<bool> running = false;
         std::thread *runner = nullptr;
+        //used instead of runner when running on a FiberPool
+        Fiber *fiber = nullptr;
         //Chronos is still alive
         std::atomic<bool> finished = false;
 
+        //set by Chronos::run, filled by the worker
+        std::shared_ptr<WorkerTelemetry> telemetry;
+        //time Chronos woke the worker (written before resume)
+        app_time_point woken_at;
+        //set by Chronos::run
+        WaitPolicy wait_policy;
+
+        void record_wake_latency();
+
         void entry_point();
 
-        void start();
+        void start(FiberPool *pool = nullptr);
+
+        void resume();
 
      public:
         Worker() = default;
@@ -77,7 +90,7 @@ namespace chronos {
          * - Chronos::get_time to see global clock
          * - @ref ready to see if chronos is still running
          *
-         * runs in its own thread \n
+         * runs in its own thread (or in a fiber if Chronos uses worker_runtime::fibers) \n
          * called by Chronos::run \n
          * should return when done computing
          */
@@ -1,5 +1,7 @@
 #include <gmock/gmock.h>
+#include <sstream>
 #include "Worker.hpp"
+#include "Executor.hpp"
 
 //1000000000 je vterina
 
@@ -17,7 +19,8 @@ class TestChronos : public Chronos {
  public:
     int ticks = 0;
 
-    TestChronos(app_duration tick_l = tick_length) : Chronos(tick_l) {};
+    TestChronos(app_duration tick_l = tick_length, worker_runtime runtime = worker_runtime::threads) :
+        Chronos(tick_l, 0, runtime) {};
 
     void tick() override {
       ticks++;
@@ -32,6 +35,12 @@ class TestChronos : public Chronos {
       });
     }
 
+    Completion<int> submit_int(int val) {
+      return submit([val]() {
+          return val + 5;
+      });
+    }
+
     std::string get_string(std::string s1, std::string s2) {
       return async([s1, s2]() {
           return "string: " + s1 + s2;
@@ -88,6 +97,22 @@ class TestWorkerPassiveSlaveZero : public Worker {
 };
 
 
+class TestWorkerBusy : public Worker {
+ public:
+    int counter;
+    app_duration busy;
+
+    TestWorkerBusy(int tick_count, app_duration busy) : counter(tick_count), busy(busy) {};
+
+    void main() override {
+      for (int i = 0; i < counter; i++) {
+        std::this_thread::sleep_for(busy);
+        sleep_until();
+      }
+    }
+};
+
+
 class TestWorkerCrash : public Worker {
  public:
     void main() override {
@@ -109,6 +134,83 @@ class TestWorkerAsync : public Worker {
 };
 
 
+class TestWorkerSubmit : public Worker {
+ public:
+    std::vector<int> nums;
+    app_time submitted = 0;
+    app_time collected = 0;
+    TestChronos &parent;
+
+    TestWorkerSubmit(TestChronos &main) : parent(main) {};
+
+    void main() override {
+      sleep_until();
+      submitted = parent.get_time();
+      std::vector<Completion<int>> completions;
+      for (int i = 0; i < 3; i++)
+        completions.push_back(parent.submit_int(i));
+      for (auto &completion: completions)
+        nums.push_back(completion.get());
+      collected = parent.get_time();
+    }
+};
+
+
+class TestWorkerFlood : public Worker {
+ public:
+    std::vector<int> nums;
+    app_time submitted = 0;
+    app_time collected = 0;
+    TestChronos &parent;
+
+    TestWorkerFlood(TestChronos &main) : parent(main) {};
+
+    void main() override {
+      sleep_until();
+      submitted = parent.get_time();
+      std::vector<Completion<int>> completions;
+      for (int i = 0; i < 6; i++)
+        completions.push_back(parent.submit_int(i));
+      for (auto &completion: completions)
+        nums.push_back(completion.get());
+      collected = parent.get_time();
+    }
+};
+
+
+class TestChronosOrder : public Chronos {
+ public:
+    std::vector<int> order;
+
+    TestChronosOrder() : Chronos(tick_length) {};
+
+    void tick() override {}
+
+    int log(int id) {
+      return async([this, id]() {
+          order.push_back(id);
+          return id;
+      });
+    }
+};
+
+class TestWorkerLogger : public Worker {
+ public:
+    int id;
+    TestChronosOrder &parent;
+
+    TestWorkerLogger(int id, TestChronosOrder &main) : id(id), parent(main) {};
+
+    void main() override {
+      for (int i = 0; i < 20; i++) {
+        parent.log(id);
+        if (i % (id + 2) == 0)
+          sleep_until(parent.get_time() + id);
+      }
+    }
+};
+
+
 class MockPassive : public TestWorkerPassive {
  public:
     MockPassive(int tick_count) : TestWorkerPassive(tick_count) {};
@@ -168,7 +270,8 @@ class TestChronosTime : public Chronos {
  public:
     int ticks = 0;
 
-    TestChronosTime(app_time p_max, app_duration tick_l = tick_length) : Chronos(tick_l, p_max) {};
+    TestChronosTime(app_time p_max, app_duration tick_l = tick_length,
+                    worker_runtime runtime = worker_runtime::threads) : Chronos(tick_l, p_max, runtime) {};
 
     void tick() override {
       ticks++;
@@ -299,8 +402,219 @@ TEST(Chronos, SingleActiveNoWaitDestructing) {
   EXPECT_GT(((double)duration.count())/TICK_LEN , 30);
 }
 
+TEST(Chronos, SinglePassiveFibers) {
+  TestChronos god(tick_length, worker_runtime::fibers);
+  TestWorkerPassive w1(100);
+  workers_list workers = {&w1};
+  god.run(workers);
+  EXPECT_EQ(god.ticks, 101);
+}
+
+TEST(Chronos, AsyncChronosFibers) {
+  TestChronos god(tick_length, worker_runtime::fibers);
+  TestWorkerAsync w1(god);
+  workers_list workers = {&w1};
+  god.run(workers);
+  god.wait(workers);
+  EXPECT_EQ(w1.num, 10);
+}
+
+TEST(Chronos, TimesGoesOnFibers) {
+  app_time g_max_time = 10;
+  TestChronosTime god(g_max_time, tick_length, worker_runtime::fibers);
+  TestWorkerTime w1(g_max_time, god);
+  workers_list workers = {&w1};
+  god.run(workers);
+  EXPECT_EQ(god.ticks, g_max_time + 1);
+  god.wait(workers);
+  EXPECT_EQ(w1.counter, 2 * g_max_time);
+}
+
+TEST(Chronos, ManyPassiveFibers) {
+  TestChronos god(tick_length_long, worker_runtime::fibers);
+  std::vector<std::unique_ptr<TestWorkerPassive>> pool;
+  workers_list workers;
+  for (int i = 0; i < 500; i++) {
+    pool.emplace_back(new TestWorkerPassive(10));
+    workers.push_back(pool.back().get());
+  }
+  god.run(workers);
+  god.wait(workers);
+  EXPECT_EQ(god.ticks, 11);
+  for (auto &w: pool)
+    EXPECT_EQ(w->still_running(), false);
+}
+
+TEST(Chronos, Telemetry) {
+  app_time g_max_time = 10;
+  TestChronosTime god(g_max_time);
+  TestWorkerPassiveSlave w1;
+  TestWorkerPassive w3(3);
+  workers_list workers = {&w1, &w3};
+  std::ostringstream dump;
+  god.set_telemetry_output(&dump);
+  god.run(workers);
+  god.wait(workers);
+  const Telemetry &telemetry = god.get_telemetry();
+  EXPECT_EQ(telemetry.tick_duration.count(), g_max_time);
+  EXPECT_EQ(telemetry.workers_woken.count(), g_max_time + 1);
+  ASSERT_EQ(telemetry.workers.size(), 2);
+  //a worker started before the first tick is woken once more
+  EXPECT_GE(telemetry.workers[0]->wake_latency.count(), g_max_time + 1);
+  EXPECT_LE(telemetry.workers[0]->wake_latency.count(), g_max_time + 2);
+  EXPECT_EQ(telemetry.workers[1]->wake_latency.count(), 3);
+  EXPECT_NE(dump.str().find("tick_duration,"), std::string::npos);
+}
+
+TEST(Chronos, TelemetryAsync) {
+  TestChronos god;
+  TestWorkerAsync w1(god);
+  workers_list workers = {&w1};
+  god.run(workers);
+  god.wait(workers);
+  const Telemetry &telemetry = god.get_telemetry();
+  EXPECT_EQ(telemetry.workers[0]->async_blocked.count(), 1);
+  EXPECT_EQ(telemetry.async_processed.mean() * telemetry.async_processed.count(), 1);
+}
+
+TEST(Chronos, AdaptiveDurationGrows) {
+  TestChronos god(std::chrono::microseconds(100));
+  god.set_adaptive_duration(std::chrono::microseconds(10), std::chrono::seconds(1));
+  TestWorkerBusy w1(30, std::chrono::milliseconds(2));
+  workers_list workers = {&w1};
+  god.run(workers);
+  //settles above the busy time, shrinking a bit during the last ticks
+  EXPECT_GT(god.get_tick_duration(), std::chrono::milliseconds(1));
+  EXPECT_LE(god.get_tick_duration(), std::chrono::seconds(1));
+}
+
+TEST(Chronos, AdaptiveDurationShrinks) {
+  TestChronos god(std::chrono::milliseconds(10));
+  god.set_adaptive_duration(std::chrono::microseconds(100), std::chrono::seconds(1));
+  TestWorkerPassive w1(100);
+  workers_list workers = {&w1};
+  god.run(workers);
+  EXPECT_LT(god.get_tick_duration(), std::chrono::milliseconds(1));
+  EXPECT_GE(god.get_tick_duration(), std::chrono::microseconds(100));
+}
+
+TEST(Chronos, MaxElapsed) {
+  TestChronos god;
+  god.set_max_elapsed(10 * tick_length);
+  TestWorkerPassiveSlave w1;
+  workers_list workers = {&w1};
+  god.run(workers);
+  EXPECT_EQ(god.ticks, 11);
+  EXPECT_EQ(god.get_elapsed(), 11 * tick_length);
+}
+
+TEST(Chronos, Submit) {
+  TestChronos god(tick_length_long);
+  TestWorkerSubmit w1(god);
+  workers_list workers = {&w1};
+  god.run(workers);
+  EXPECT_EQ(w1.nums, std::vector<int>({5, 6, 7}));
+  //all the tasks are processed by the same process_async
+  EXPECT_LE(w1.collected, w1.submitted + 1);
+}
+
+TEST(Chronos, SubmitFibers) {
+  TestChronos god(tick_length_long, worker_runtime::fibers);
+  TestWorkerSubmit w1(god);
+  workers_list workers = {&w1};
+  god.run(workers);
+  EXPECT_EQ(w1.nums, std::vector<int>({5, 6, 7}));
+  EXPECT_LE(w1.collected, w1.submitted + 1);
+}
+
+TEST(Chronos, ManyPassiveSpinning) {
+  TestChronosTime god(100, tick_length_long);
+  god.set_wait_policy({1000, 10});
+  god.set_cpu(0);
+  TestWorkerPassiveSlave w1, w2, w3;
+  workers_list workers = {&w1, &w2, &w3};
+  god.run(workers);
+  EXPECT_EQ(god.ticks, 101);
+  god.wait(workers);
+  //no tick missed (a worker started before the first tick counts one more)
+  EXPECT_GE(w1.ticks, 101);
+  EXPECT_GE(w3.ticks, 101);
+}
+
+TEST(Chronos, AsyncBudget) {
+  TestChronos god(tick_length_long);
+  god.set_async_budget(2);
+  TestWorkerFlood w1(god);
+  TestWorkerAsync w2(god);
+  workers_list workers = {&w1, &w2};
+  god.run(workers);
+  EXPECT_EQ(w1.nums, std::vector<int>({5, 6, 7, 8, 9, 10}));
+  EXPECT_EQ(w2.num, 10);
+  //six tasks of w1 need at least three ticks
+  EXPECT_GE(w1.collected, w1.submitted + 2);
+  //at most two tasks per worker in a tick
+  EXPECT_LE(god.get_telemetry().async_processed.max(), 4);
+}
+
+TEST(Chronos, Executor) {
+  Executor executor(2);
+  TestChronosTime god1(100), god2(50, tick_length_long);
+  TestWorkerPassiveSlave w1, w2;
+  TestWorkerPassive w3(20);
+  std::thread t1([&]() { executor.run(god1, {&w1}); });
+  std::thread t2([&]() { executor.run(god2, {&w2, &w3}); });
+  t1.join();
+  t2.join();
+  EXPECT_EQ(god1.ticks, 101);
+  EXPECT_EQ(god2.ticks, 51);
+  Chronos::wait({&w1, &w2, &w3});
+  EXPECT_GE(w1.ticks, 101);
+  EXPECT_GE(w2.ticks, 51);
+}
+
+TEST(Chronos, ExecutorAsync) {
+  Executor executor(1);
+  TestChronos god1(tick_length_long), god2(tick_length_long);
+  TestWorkerAsync w1(god1), w2(god2);
+  std::thread t1([&]() { executor.run(god1, {&w1}); });
+  std::thread t2([&]() { executor.run(god2, {&w2}); });
+  t1.join();
+  t2.join();
+  EXPECT_EQ(w1.num, 10);
+  EXPECT_EQ(w2.num, 10);
+}
+
+TEST(Chronos, JournalReplay) {
+  std::stringstream journal;
+  std::vector<int> recorded;
+  {
+    TestChronosOrder god;
+    god.set_journal_output(&journal);
+    TestWorkerLogger w1(0, god), w2(1, god), w3(2, god);
+    god.run({&w1, &w2, &w3});
+    Chronos::wait({&w1, &w2, &w3});
+    recorded = god.order;
+  }
+  EXPECT_EQ(recorded.size(), 60);
+  for (int attempt = 0; attempt < 3; attempt++) {
+    std::istringstream input(journal.str());
+    TestChronosOrder god;
+    god.set_journal_input(input);
+    TestWorkerLogger w1(0, god), w2(1, god), w3(2, god);
+    god.run({&w1, &w2, &w3});
+    Chronos::wait({&w1, &w2, &w3});
+    EXPECT_FALSE(god.get_replay_diverged());
+    EXPECT_EQ(god.order, recorded);
+  }
+}
+
+TEST(Chronos, JournalInvalid) {
+  std::istringstream input("not a journal");
+  TestChronosOrder god;
+  EXPECT_THROW(god.set_journal_input(input), error);
+}
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
@@ -48,7 +48,8 @@ int main()
                          edetailedcompetiton,
                          emaslovcompetition,
                          eoriginalcompetition,
-                         ebuyerscompetition};
+                         ebuyerscompetition,
+                         eparallelcheck};
 
         // change accordingly
         ewhattodo whattodo = emaslovcompetition;
@@ -141,6 +142,21 @@ int main()
                     originalcompetition<chronos,logging>({&fs,&ss}, competitorsendowment, cdef, std::clog);
             }
             break;
+        case eparallelcheck:
+            {
+                // checks that the parallel simulation gives the same results as the serial one
+                competitor<testedstrategy,false> s(tsname);
+                competitor<maslovstrategy,false> m("msdlob");
+                def.edthreads = 4;
+                // otherwise every batch would consist of a single event
+                def.edparallelwindow = 10;
+                if(!edparallelequalsserial({&s,&m},runningtime,competitorsendowment,def))
+                    throw "parallel simulation differs from the serial one";
+                if(!edoptimisticequalsserial({&s,&m},runningtime,
+                        std::vector<twallet>(2,competitorsendowment),def))
+                    throw "optimistic simulation differs from the serial one";
+            }
+            break;
         case ebuyerscompetition:
             {
             /// work under progress
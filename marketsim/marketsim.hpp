@@ -11,8 +11,17 @@
 #include <atomic>
 #include <algorithm>
 #include <math.h>
+#include <time.h>
+#include <mutex>
+#include <exception>
 #include "Chronos.hpp"
 #include "Worker.hpp"
+#include "Executor.hpp"
+#include "marketsim/workstealingpool.hpp"
+#include "marketsim/eventqueue.hpp"
+#include "marketsim/cputime.hpp"
+#include "marketsim/checkpoint.hpp"
+#include "marketsim/statistics.hpp"
 
 // the namespace encapulating all the library
 namespace marketsim
@@ -39,31 +48,19 @@ public:
    marketsimerror(const std::string &what = "") : error(what) {}
 };
 
-/// class used to collect statistical information (TBD move to orpp)
-struct statcounter
-{
-    double sum = 0.0;
-    double sumsq = 0.0;
-    unsigned num = 0;
-    void add(double x) { sum += x; sumsq += x*x; num++;}
-    double average() const { return sum / num; }
-    double var() const { return sumsq/num - average()*average(); }
-    double averagevar() const  { return var() / num; }
-
-};
-
-
 template <typename T>
 class finitedistribution
 {
 public:
     void add(double p,const T& x)
     {
-        item m = { p,x };
-        fx.insert(std::upper_bound( fx.begin(), fx.end(), m , cmp),                  m                );
+        // sorted lazily (stably, i.e. as if inserted after the equal items)
+        fx.push_back({ p,x });
+        fsorted = false;
     }
     double lowerCVaR(double alpha) const
     {
+        sort();
         double sum = 0;
         double psum = 0;
         for(auto it = fx.begin(); it != fx.end(); it++)
@@ -97,7 +94,14 @@ private:
     {
         return a.x < b.x;
     }
-    std::vector<item> fx;
+    void sort() const
+    {
+        if(!fsorted)
+            std::stable_sort(fx.begin(), fx.end(), cmp);
+        fsorted = true;
+    }
+    mutable std::vector<item> fx;
+    mutable bool fsorted = true;
 };
 
 using tprice = int;
@@ -402,6 +406,11 @@ public:
         }
     }
 
+    /// writes the orders to binary stream \p o (see marketsim::savebinary)
+    void save(std::ostream& o) const { savebinary(o,fx); }
+    /// reads the orders written by marketsim::tsortedordercontainer::save
+    void load(std::istream& i) { loadbinary(i,fx); }
+
     /// removes all orders with zero volume
     void removezeros()
     {
@@ -633,6 +642,20 @@ public:
 
 
 
+    /// writes both the lists to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        B.save(o);
+        A.save(o);
+    }
+
+    /// reads the lists written by marketsim::tprofilebase::save
+    void load(std::istream& i)
+    {
+        B.load(i);
+        A.load(i);
+    }
+
     /// output to a stream
     void output(std::ostream& o) const
     {
@@ -725,6 +748,26 @@ public:
     /// accessor
     void seteraserequest(const teraserequest& r) { feraserequest = r; }
 
+    /// writes the request to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        savebinary(o,fconsumption);
+        forderrequest.save(o);
+        savebinary(o,feraserequest.all);
+        savebinary(o,feraserequest.a);
+        savebinary(o,feraserequest.b);
+    }
+
+    /// reads the request written by marketsim::trequest::save
+    void load(std::istream& i)
+    {
+        loadbinary(i,fconsumption);
+        forderrequest.load(i);
+        loadbinary(i,feraserequest.all);
+        loadbinary(i,feraserequest.a);
+        loadbinary(i,feraserequest.b);
+    }
+
     /// if true then the request would certainly have no effect
     bool empty() const
     {
@@ -834,6 +877,11 @@ public:
         return a.t < b.t;
     }
     const std::vector<S>& x() const { return fx; }
+
+    /// writes the records to binary stream \p o (see marketsim::savebinary)
+    void save(std::ostream& o) const { savebinary(o,fx); }
+    /// reads the records written by marketsim::tjumpprocess::save
+    void load(std::istream& i) { loadbinary(i,fx); }
 private:
     std::vector<S> fx;
 
@@ -1191,7 +1239,39 @@ public:
     }
 
     void addcomptime(tabstime t) {fcomptimes.add(t);}
-    const statcounter& comptimes() const { return fcomptimes; }
+    /// computing times of the strategy (see marketsim::tmarketdef::comptimeclock)
+    const distributioncounter& comptimes() const { return fcomptimes; }
+
+    /// writes the state (the wallet and the histories, not the identification and the log)
+    /// to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        savebinary(o,fwallet);
+        savebinary(o,fblockedmoney);
+        savebinary(o,fblockedstocks);
+        fconsumption.save(o);
+        ftrading.save(o);
+        fds.save(o);
+        fcomptimes.save(o);
+        savebinary(o,fendedbyexception);
+        savebinary(o,ferrmsg);
+        savebinary(o,foverrun);
+    }
+
+    /// reads the state written by marketsim::tstrategyinfo::save
+    void load(std::istream& i)
+    {
+        loadbinary(i,fwallet);
+        loadbinary(i,fblockedmoney);
+        loadbinary(i,fblockedstocks);
+        fconsumption.load(i);
+        ftrading.load(i);
+        fds.load(i);
+        fcomptimes.load(i);
+        loadbinary(i,fendedbyexception);
+        loadbinary(i,ferrmsg);
+        loadbinary(i,foverrun);
+    }
 protected:
     tstrategyid fid;
     std::string fname;
@@ -1201,7 +1281,7 @@ protected:
     tjumpprocess<tconsumptionevent> fconsumption;
     tjumpprocess<tradingevent> ftrading;
     tjumpprocess<tdsevent> fds;
-    statcounter fcomptimes;
+    distributioncounter fcomptimes;
 
     std::ostringstream fsublog;
     bool fendedbyexception = false;
@@ -1216,8 +1296,36 @@ struct trequestresult
     tvolume q = 0;
     /// errors encountered
     std::vector<tsettleerror> errs;
+
+    /// writes the result to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        savebinary(o,q);
+        savebinary(o,static_cast<unsigned>(errs.size()));
+        for(const auto& e: errs)
+        {
+            savebinary(o,e.w);
+            savebinary(o,e.text);
+        }
+    }
+
+    /// reads the result written by marketsim::trequestresult::save
+    void load(std::istream& i)
+    {
+        loadbinary(i,q);
+        unsigned n = loadlength<unsigned>(i,1);
+        errs.resize(n);
+        for(auto& e: errs)
+        {
+            loadbinary(i,e.w);
+            loadbinary(i,e.text);
+        }
+    }
 };
 
+/// handle of a result of marketsim::tstrategy::requestasync
+using trequesthandle = chronos::Completion<trequestresult>;
+
 
 class tmarket;
 class tmarketinfo;
@@ -1246,12 +1354,28 @@ public:
 
     virtual ~tdsbase() {}
     virtual tdsrecord delta(tabstime, const tmarketdata&)=0;
+
+    /// Optional extension: returns the time of the first arrival of demand or supply after time
+    /// \p t, i.e. the time at which marketsim::tdsbase::delta is to be called next (by the event
+    /// driven simulation, which then skips the times in between). The default returns \p t +
+    /// marketsim::tmarketdef::demandupdateperiod, i.e. the generator is polled regularly.
+    virtual tabstime nextarrival(tabstime t);
+
+    /// Optional support of checkpoints (see marketsim::tmarket::checkpointto): writes
+    /// the state of the generator to binary stream \p o and returns \c true. The default
+    /// returns \c false, meaning that the generator cannot be checkpointed.
+    virtual bool savestate(std::ostream& /* o */) const { return false; }
+
+    /// restores the state written by marketsim::tdsbase::savestate from \p i
+    virtual void restorestate(std::istream& /* i */) {}
 };
 
 class tnodemandsupply : public tdsbase
 {
     friend class tmarket;
     virtual tdsrecord delta(tabstime, const tmarketdata&) { return {0,0}; }
+    virtual tabstime nextarrival(tabstime) { return std::numeric_limits<tabstime>::max(); }
+    virtual bool savestate(std::ostream&) const { return true; }
 };
 
 
@@ -1275,15 +1399,16 @@ private:
     virtual void main() override;
 
     /// assigns an unique (within run of the application) id to a strategy
+    /// (thread safe, markets may run concurrently)
     static tstrategyid newid()
     {
-        static int currid = 1;
+        static std::atomic<int> currid(1);
         return currid++;
     }
 protected:
 
     /// constructor, \p name is recommended to be unique to each instance
-    tstrategy(tabstime warmingtime = 0) : fid(newid()), fmarket(0), fwarmingtime(warmingtime)
+    tstrategy(tabstime warmingtime = 0) : fid(newid()), fmarket(0), findex(0), fwarmingtime(warmingtime)
     {
     }
 //    ~tstrategy() {}
@@ -1312,6 +1437,13 @@ protected:
         return internalrequest<true>(request);
     }
 
+    /// Sends a request \p request to the market without waiting for its settlement (RT interface).
+    /// Requests are settled in the order they were sent (including those sent by
+    /// marketsim::tstrategy::request), so several of them can be sent within one tick. The result is
+    /// returned by \c get() of the handle (which blocks until the request is settled, and may be called
+    /// only once), \c ready() tells whether it already has been.
+    trequesthandle requestasync(const trequest& request);
+
     /// Returns a state of the market as of the time the method is called (RT interface).
     tmarketinfo getinfo();
 
@@ -1334,6 +1466,8 @@ protected:
 
 protected:
     const tmarket* market() const { return fmarket; }
+    /// index of the strategy in the market (the order of the strategies passed to marketsim::tmarket::run)
+    unsigned index() const { return findex; }
     void possiblylog(const std::string&
                  shortmsg, const std::string& longmsg = "");
 
@@ -1348,6 +1482,8 @@ private:
     /// is set by (friend) class tmarket
     twallet fendowment;
     tmarket* fmarket;
+    /// index in marketsim::tmarketdata, is set by (friend) class tmarket
+    unsigned findex;
     tabstime fwarmingtime;
 
 };
@@ -1383,6 +1519,10 @@ public:
     /// Intended to provide a string identification of a strategy
     virtual std::string name() const = 0;
     virtual bool startswithoutwarmup() const = 0;
+    /// stable identification of the strategy beyond its name (distinguishes strategies
+    /// with the same name but e.g. different parameters), part of the keys of the cached
+    /// runs (see marketsim::tcompetitiondef::cachedir)
+    virtual std::string key() const { return ""; }
 
 };
 
@@ -1395,10 +1535,12 @@ template<typename S, bool chronos = false, bool nowarmup = false>
 class competitor : public competitorbase<chronos>
 {
     const std::string fname;
+    const std::string fkey;
 public:
-    /// constructor
-    competitor<S,chronos,nowarmup>(const std::string& aname = typeid(S).name())
-        : fname(aname) {}
+    /// constructor, \p akey is returned by \c key()
+    competitor<S,chronos,nowarmup>(const std::string& aname = typeid(S).name(),
+                                   const std::string& akey = "")
+        : fname(aname), fkey(akey) {}
 
     /// actual \c create method (why it has a pure parent?)
     virtual typename selectstragegybase<chronos>::basetype* create()
@@ -1410,6 +1552,7 @@ public:
     /// accessor
     virtual std::string name() const { return fname; }
     virtual bool startswithoutwarmup() const { return nowarmup; }
+    virtual std::string key() const { return fkey; }
 };
 
 
@@ -1437,6 +1580,7 @@ struct tloggingfilter
         fmarketdata = false;
         fds = false;
         fprotocol = false;
+        ftelemetry = false;
     }
     bool frequest;
     bool fsettle;
@@ -1447,6 +1591,8 @@ struct tloggingfilter
     bool fabstime;
     bool fds;
     bool fprotocol;
+    /// RT only: the Chronos telemetry (see chronos::Telemetry) is written at the end of the log
+    bool ftelemetry;
 };
 
 
@@ -1504,6 +1650,11 @@ public:
     template <bool logging = false>
     void calibrate(unsigned ncompetitors, std::ostream& log = std::clog)
     {
+        if(adaptivechronosduration)
+        {
+            log << "Adaptive chronos duration, calibration skipped." << std::endl;
+            return;
+        }
         log << "Calibrating for " << ncompetitors << " competitors." << std::endl;
         chronosduration = chronos::app_duration(findduration<logging>(ncompetitors,*this,log));
         log << "ticktime() = " << ticktime() << std::endl;
@@ -1513,6 +1664,48 @@ public:
     /// Best is to use marketsim::calibrate to set it in run-time.
     chronos::app_duration chronosduration = chronos::app_duration(100000);
 
+    /// RT only: if \c true, Chronos adjusts the tick duration while running (lengthening it when
+    /// strategies overrun a tick, shortening it when they idle), starting from \c chronosduration and
+    /// keeping it within [\c minchronosduration, \c maxchronosduration]. The absolute time is then
+    /// the sum of the durations of the ticks elapsed and marketsim::tmarketdef::calibrate is not needed.
+    bool adaptivechronosduration = false;
+
+    /// lower bound of the tick duration if \c adaptivechronosduration is set
+    chronos::app_duration minchronosduration = chronos::app_duration(1000);
+
+    /// upper bound of the tick duration if \c adaptivechronosduration is set
+    chronos::app_duration maxchronosduration = chronos::app_duration(100000000);
+
+    /// RT only: with chronos::worker_runtime::fibers the strategies do not get own threads but run as
+    /// fibers on a pool sized to the number of cores (marketsim::tstrategy::trade needs no change)
+    chronos::worker_runtime workerruntime = chronos::worker_runtime::threads;
+
+    /// RT only: how Chronos and the strategies wait for each other (see chronos::WaitPolicy); spinning
+    /// allows very short ticks (microseconds) but needs a core per strategy plus one for Chronos
+    chronos::WaitPolicy waitpolicy = chronos::WaitPolicy();
+
+    /// RT only: core the Chronos thread (the one calling marketsim::tmarket::run) is pinned to
+    /// during the run, -1 means no pinning
+    int chronoscpu = -1;
+
+    /// RT only: maximal number of requests (and other calls to the market) of a single strategy
+    /// settled within one tick, 0 means no limit. The strategies' calls are settled round robin,
+    /// so a strategy flooding the market with requests does not delay the others.
+    unsigned asyncbudget = 0;
+
+    /// RT only: if not null, the market is run by this executor, which may run other markets
+    /// concurrently (called from other threads), the strategies of all of them sharing its pool
+    /// of threads as fibers (\c workerruntime and \c chronoscpu are then ignored)
+    chronos::Executor* executor = nullptr;
+
+    /// RT only: if not empty, the order in which the calls of the strategies to the market are
+    /// processed (and the ticks they are processed in) is recorded to this (binary) file
+    std::string journalrecordfile;
+
+    /// RT only: if not empty, the run repeats the order recorded to this file by \c journalrecordfile
+    /// (with deterministic strategies, the simulation is then repeated exactly)
+    std::string journalreplayfile;
+
     /// magnitude of "noise" added to the waiting times given ED
     double epsilon = 0.0000001;
 
@@ -1522,6 +1715,64 @@ public:
 
     tabstime demandupdateperiod = 0.1;
 
+    /// ED only: number of threads calling marketsim::teventdrivenstrategy::event concurrently
+    /// (1 means strictly serial simulation, 0 means the number of cores). If other than 1,
+    /// the events are evaluated speculatively in parallel (see \c edparallelwindow and
+    /// \c edoptimistic), the results being the same as those of the serial simulation
+    /// (up to the computation times), unless \c edfrozenmarket. With logging on, the
+    /// simulation is serial.
+    unsigned edthreads = 1;
+
+    /// ED only, \c edthreads other than 1 and not \c edoptimistic: the events due at most
+    /// \c edparallelwindow after the earliest one (and before the next pending request or
+    /// demand/supply event) are evaluated concurrently, predicting that the market and the
+    /// random generator will not change meanwhile; an event whose prediction fails is rolled
+    /// back and evaluated again (as with \c edoptimistic). Note that rolling back needs
+    /// checkpoints (see marketsim::teventdrivenstrategy::savestate), so the events of the
+    /// strategies not supporting them are never evaluated concurrently (only when they
+    /// are the earliest ones), i.e. this mode gives them no concurrency; see
+    /// \c edfrozenmarket.
+    tabstime edparallelwindow = 0;
+
+    /// ED only, \c edthreads other than 1 and not \c edoptimistic: if \c true, all the
+    /// events due at most \c edparallelwindow after the earliest one (and before the next
+    /// pending request or demand/supply event) are evaluated concurrently against the market
+    /// as of the earliest one and their requests are settled in timestamp order, without any
+    /// rollback, so also strategies without checkpoints run concurrently. The results then
+    /// differ from those of the serial simulation: the events do not see the requests issued
+    /// within the window. They do not depend on \c edthreads, as every strategy draws from its
+    /// own random generator (\c independentrandomstreams is set). Checkpoints of the run
+    /// (see marketsim::tmarket::checkpointto) are not supported.
+    bool edfrozenmarket = false;
+
+    /// ED only, \c edthreads other than 1: if \c true, the simulation is optimistic (and
+    /// \c edparallelwindow is ignored): the events following the current one (and preceding the
+    /// next request settlement and demand/supply event) are evaluated speculatively in parallel,
+    /// predicting that the market and the random generator will not change meanwhile; an event
+    /// whose prediction fails is rolled back (see marketsim::teventdrivenstrategy::savestate)
+    /// and evaluated again, so the results are the same as those of the serial simulation.
+    /// Only strategies supporting checkpoints are evaluated speculatively (the others only
+    /// when their events are the earliest ones).
+    bool edoptimistic = false;
+
+    /// ED only, \c edoptimistic: maximal number of events evaluated at once (0 means twice the number of threads)
+    unsigned edspeculationdepth = 0;
+
+    /// if \c true, every strategy draws from its own random generator, the demand/supply
+    /// generator from another one and the noise added to the times of events
+    /// (see \c epsilon) from yet another ones, all of them derived from the seed of the
+    /// market and the index of the strategy; so the random draws of one strategy do not
+    /// shift those of the others and the runs of competitions with the same seed differing
+    /// only by one competitor face the same background (common random numbers)
+    bool independentrandomstreams = false;
+
+    /// ED only: clock measuring the computation times of the strategies' events (also used
+    /// when the time of learning is subtracted, see marketsim::teventdrivenstrategy::startlearning)
+    tcomptimeclock comptimeclock = tcomptimeclock::thread;
+
+    /// ED only: converts the measured computation times to the times charged to the strategies
+    tcomptimemodel comptimemodel = tcomptimemodel();
+
     tabstime warmuptime = 1;
 
     /// if \c false and logging is used then the logging is done to std::ostringstream's first and then written,
@@ -1546,9 +1797,69 @@ public:
             /static_cast<double>(chronos::app_duration::period::den);
         return chronosduration.count() * tl;
     }
+
+    /// writes the parameters which may influence the results of a simulation to binary
+    /// stream \p o (neither logging nor performance tuning parameters, used
+    /// to key cached results of runs)
+    void savekey(std::ostream& o) const
+    {
+        savebinary(o,static_cast<long long>(chronosduration.count()));
+        savebinary(o,adaptivechronosduration);
+        savebinary(o,static_cast<long long>(minchronosduration.count()));
+        savebinary(o,static_cast<long long>(maxchronosduration.count()));
+        savebinary(o,workerruntime);
+        savebinary(o,asyncbudget);
+        savebinary(o,journalreplayfile);
+        savebinary(o,epsilon);
+        savebinary(o,timeowaitafterend);
+        savebinary(o,demandupdateperiod);
+        savebinary(o,edthreads);
+        savebinary(o,edparallelwindow);
+        savebinary(o,edoptimistic);
+        savebinary(o,edfrozenmarket);
+        savebinary(o,independentrandomstreams);
+        savebinary(o,comptimeclock);
+        savebinary(o,comptimemodel);
+        savebinary(o,warmuptime);
+    }
 };
 
 
+/// Collector of metrics of a run of marketsim::tmarket (see marketsim::tmarket::addcollector).
+/// The market notifies it of the events of the run as they happen, so the metrics accumulate
+/// online and are read once the run is over, without rescanning the histories. The strategies
+/// are identified by their indices in the market's list.
+class tmetriccollector
+{
+public:
+    virtual ~tmetriccollector() {}
+
+    /// called before the run (ending at \p maxtime), \p data is the initial state of the market
+    virtual void start(const tmarketdata& /* data */, tabstime /* maxtime */) {}
+    /// called after a request of strategy \p owner has been settled, \p s is the resulting
+    /// state of the market (as added to marketsim::tmarketdata::fhistory)
+    virtual void settle(unsigned /* owner */, const tsnapshot& /* s */) {}
+    /// strategy \p i traded with \p partner at \p t (called for both the parties)
+    virtual void trade(unsigned /* i */, tprice /* moneydelta */, tvolume /* stockdelta */,
+                       tabstime /* t */, unsigned /* partner */) {}
+    /// strategy \p i consumed \p c at \p t
+    virtual void consumption(unsigned /* i */, tprice /* c */, tabstime /* t */) {}
+    /// strategy \p i received demand \p demand or supply \p supply at \p t
+    virtual void ds(unsigned /* i */, tprice /* demand */, tvolume /* supply */, tabstime /* t */) {}
+    /// called after every tick of the RT simulation (after every processed event, request or
+    /// demand/supply arrival of the ED simulation), \p t is the current time
+    virtual void tick(tabstime /* t */) {}
+    /// called after the run (also if it failed), \p data is the final state of the market
+    virtual void end(const tmarketdata& /* data */) {}
+
+    /// Optional support of checkpoints (see marketsim::tmarket::checkpointto): writes
+    /// the state of the collector to binary stream \p o and returns \c true. The default
+    /// returns \c false, meaning that the collector cannot be checkpointed.
+    virtual bool savestate(std::ostream& /* o */) const { return false; }
+
+    /// restores the state written by marketsim::tmetriccollector::savestate from \p i
+    virtual void restorestate(std::istream& /* i */) {}
+};
 
 
 /// a collection of all the pending orders on the market
@@ -1656,15 +1967,22 @@ public:
     /// is done according to FIFO altorithm. If there is not enough mony or stocks to buy, sell,
     /// respectively, the request (for a single particular order) is not fulfilled and a
     /// warning is issued. Same with insufficiency of money/stocks needed to be blocked when
-    /// limit order is sissued.
+    /// limit order is sissued. The consumption and the trades are reported to \p collectors.
     trequestresult settle(
                        const trequest& arequest,
                        std::vector<tstrategyinfo>& profiles,
                        unsigned owner,
                        ttimestamp ts,
-                       tabstime at)
+                       tabstime at,
+                       const std::vector<tmetriccollector*>& collectors = {})
     {
         assert(consistencycheck(profiles));
+        auto addtrade = [&](unsigned i, tprice moneydelta, tvolume stockdelta, unsigned partner)
+        {
+            profiles[i].addtrade(moneydelta, stockdelta, at, partner);
+            for(auto c: collectors)
+                c->trade(i, moneydelta, stockdelta, at, partner);
+        };
         trequestresult ret;
         assert(owner < numstrategies());
         auto am = profiles[owner].availablemoney();
@@ -1682,6 +2000,8 @@ public:
         {
             auto& r = profiles[owner];
             r.addconsumption(c,at);
+            for(auto col: collectors)
+                col->consumption(owner, c, at);
         }
         tpreorderprofile request = arequest.orderrequest();
         if(!request.checkcrossed())
@@ -1791,8 +2111,8 @@ public:
                         }
                         if(toexec > 0)
                         {
-                            profiles[owner].addtrade(-price * toexec, toexec, at,fa[j]->owner);
-                            profiles[fa[j]->owner].addtrade(price * toexec, -toexec, at, owner);
+                            addtrade(owner, -price * toexec, toexec, fa[j]->owner);
+                            addtrade(fa[j]->owner, price * toexec, -toexec, owner);
                             profiles[fa[j]->owner].blockedstocks() -= toexec;
                             fa[j]->volume -= toexec;
                             remains -= toexec;
@@ -1847,8 +2167,8 @@ public:
 
                     if(toexec > 0)
                     {
-                        profiles[owner].addtrade(price * toexec, -toexec, at, fb[j]->owner);
-                        profiles[fb[j]->owner].addtrade(-price * toexec, toexec, at, owner);
+                        addtrade(owner, price * toexec, -toexec, fb[j]->owner);
+                        addtrade(fb[j]->owner, -price * toexec, toexec, owner);
                         profiles[fb[j]->owner].blockedmoney() -= fb[j]->price * toexec;
                         fb[j]->volume -= toexec;
                         remains -= toexec;
@@ -1884,6 +2204,22 @@ public:
     /// accessor to the number of strategies
     unsigned numstrategies() const { return fbook.size(); }
 
+    /// writes the profiles of the strategies to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        for(const auto& p: fbook)
+            p.save(o);
+    }
+
+    /// reads the profiles written by marketsim::torderbook::save (the number of strategies
+    /// has to be the same)
+    void load(std::istream& i)
+    {
+        for(auto& p: fbook)
+            p.load(i);
+        sort();
+    }
+
     /// returns the profile of pending orders of strategy \p i
     const torderprofile& profile(unsigned i) const
     {
@@ -1979,6 +2315,7 @@ public:
         fhistory(src.fhistory),
         forderbook(src.forderbook.duplicate()),
         ftimestamp(src.ftimestamp),
+        fversion(src.fversion),
         fmarketsublog(src.fmarketsublog.str()),
         fds(src.fds),
         fstartclocktime(src.fstartclocktime),
@@ -1998,12 +2335,46 @@ public:
 
     /// current timestamp (unique integer used for determining priority of the orders)
     ttimestamp ftimestamp;
+    /// incremented on every change of the market (request settlement, demand/supply),
+    /// used by the optimistic ED simulation to tell whether its snapshot is still valid
+    unsigned long long fversion = 0;
     /// system time in seconds at the start of simulations (trimmed to seconds)
     clock_t fstartclocktime;
     /// stream for log entries originated by marketsim::tmarket
     std::ostringstream fmarketsublog;
     /// collects remaining time in ticks (used by marketsim::calibrate)
-    statcounter fextraduration;
+    distributioncounter fextraduration;
+
+    /// writes the state of the market (the infos of the strategies, the history and the order
+    /// book, not the logs) to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        savebinary(o,static_cast<unsigned>(fstrategyinfos.size()));
+        for(const auto& si: fstrategyinfos)
+            si.save(o);
+        fhistory.save(o);
+        forderbook.save(o);
+        savebinary(o,ftimestamp);
+        savebinary(o,fversion);
+        fextraduration.save(o);
+    }
+
+    /// reads the state written by marketsim::tmarketdata::save (the number of strategies
+    /// has to be the same)
+    void load(std::istream& i)
+    {
+        unsigned n = 0;
+        loadbinary(i,n);
+        if(n != fstrategyinfos.size())
+            throw marketsimerror("Checkpoint has a different number of strategies");
+        for(auto& si: fstrategyinfos)
+            si.load(i);
+        fhistory.load(i);
+        forderbook.load(i);
+        loadbinary(i,ftimestamp);
+        loadbinary(i,fversion);
+        fextraduration.load(i);
+    }
 
 
     ///
@@ -2068,155 +2439,9 @@ public:
     ///
     /// Demand/Supply passed to the strategies
     ///
-    void protocol(std::ostream& o, tabstime T, unsigned nsnaps = 10) const
-    {
-        o << std::endl << "Protocol of a market simulation"
-          << std::endl << std::endl;
-        o << "strategies:";
-
-        for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            o << "," << fstrategyinfos[i].name();
-        o << std::endl;
-        o << "c:";
-        for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            o << "," << fstrategyinfos[i].totalconsumption();
-        o << std::endl;
-        o << "m:";
-        for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            o << "," << fstrategyinfos[i].wallet().money();
-        o << std::endl;
-        o << "n:";
-        for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            o << "," << fstrategyinfos[i].wallet().stocks();
-        o << std::endl;
-        o << "# events:";
-        for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            o << "," << fstrategyinfos[i].comptimes().num;
-        o << std::endl;
-        o << "ave comp time:";
-        for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            o << "," << fstrategyinfos[i].comptimes().average();
-        o << std::endl;
-        o << std::endl;
-
-        o << "time snapshots:";
-
-        tabstime dt = T/nsnaps;
-        if(isnan(T))
-            o << ",no records in market history" << std::endl;
-        else
-        {
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << i * dt;
-            o << std::endl;
-            o << "b:";
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << p2str(fhistory(i * dt).b);
-            o << std::endl;
-
-
-
-//            o << "last def in int:";
-//            for(unsigned i=1; i<=nsnaps; i++)
-//            {
-//                o << ",";
-//                tprice lb = this->fhistory.lastdefined<tmarkethistory::efindb>((i-1)*dt,i * dt).b;
-//                if(lb != klundefprice)
-//                    o << lb;
-//            }
-//            o << std::endl;
-            o << "% undef:";
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << 100 * this->fhistory.timeundefined<tmarkethistory::efindb>((i-1)*dt,i * dt) / dt;
-            o << std::endl;
-
-            o << "B volume:";
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << fhistory(i * dt).Bvol;
-            o << std::endl;
-
-            o << "a:";
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << p2str(fhistory(i * dt).a);
-            o << std::endl;
-            o << "% undef:";
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << 100 * this->fhistory.timeundefined<tmarkethistory::efinda>((i-1)*dt,i * dt)/dt;
-            o << std::endl;
-
-            o << "A volume:";
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << fhistory(i * dt).Avol;
-            o << std::endl;
-
-
-            o << "q:";
-            for(unsigned i=1; i<=nsnaps; i++)
-                o << "," << fhistory.sumq((i-1)*dt,i * dt);
-            o << std::endl;
-            o << std::endl;
-
-            o << "Consumption" << std::endl;
-            for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            {
-                o << fstrategyinfos[i].name();
-                for(unsigned j=1; j<=nsnaps; j++)
-                    o << "," << fstrategyinfos[i].consumption().evaluate
-                           <double, tstrategyinfo::tconsumptionevent::getc>((j-1)*dt,j * dt);
-                o << std::endl;
-            }
-
-            o << std::endl;
-
-
-            o << "Purchases" << std::endl;
-            for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            {
-                o << fstrategyinfos[i].name();
-                for(unsigned j=1; j<=nsnaps; j++)
-                    o << "," << fstrategyinfos[i].tradinghistory().evaluate
-                           <double, tstrategyinfo::tradingevent::getstockpurchase>((j-1)*dt,j * dt);
-                o << std::endl;
-            }
-
-            o << std::endl;
-
-            o << "Selling" << std::endl;
-            for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            {
-                o << fstrategyinfos[i].name();
-                for(unsigned j=1; j<=nsnaps; j++)
-                    o << "," << fstrategyinfos[i].tradinghistory().evaluate
-                           <double, tstrategyinfo::tradingevent::getstockselling>((j-1)*dt,j * dt);
-                o << std::endl;
-            }
-
-            o << std::endl;
-
-            o << "Demand" << std::endl;
-            for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            {
-                o << fstrategyinfos[i].name();
-                for(unsigned j=1; j<=nsnaps; j++)
-                    o << "," << fstrategyinfos[i].dshistory().evaluate
-                           <double, tdsevent::getdemand>((j-1)*dt,j * dt);
-                o << std::endl;
-            }
-
-            o << std::endl;
-
-            o << "Supply" << std::endl;
-            for(unsigned i=0; i<fstrategyinfos.size(); i++)
-            {
-                o << fstrategyinfos[i].name();
-                for(unsigned j=1; j<=nsnaps; j++)
-                    o << "," << fstrategyinfos[i].dshistory().evaluate
-                           <double, tdsevent::getsupply>((j-1)*dt,j * dt);
-                o << std::endl;
-            }
-            o << std::endl;
-        }
-    }
+    /// (the histories are passed to marketsim::tprotocolcollector, which gives the same
+    /// tables during the run, see marketsim/collectors.hpp)
+    void protocol(std::ostream& o, tabstime T, unsigned nsnaps = 10) const;
 };
 
 /// accessor of a particular strategy to marketsim::tmarketdata (the strategy should not see
@@ -2307,6 +2532,16 @@ public:
 
     /// called by the simulator after the end of simulation
     virtual void sequel(const tmarketinfo&) {}
+
+    /// Optional support of checkpoints: writes the state of the strategy (everything
+    /// marketsim::teventdrivenstrategy::event may change, the state of this base class excepted)
+    /// to binary stream \p o and returns \c true. The default returns \c false, meaning that
+    /// the strategy cannot be checkpointed (and thus not evaluated speculatively
+    /// with marketsim::tmarketdef::edoptimistic). See also marketsim::savebinary.
+    virtual bool savestate(std::ostream& /* o */) const { return false; }
+
+    /// restores the state written by marketsim::teventdrivenstrategy::savestate from \p i
+    virtual void restorestate(std::istream& /* i */) {}
 protected:
     /// accessor
     double interval() const { return finterval; }
@@ -2325,6 +2560,24 @@ protected:
 private:
 //    tabstime step(tabstime t, bool firsttime);
 
+    /// saves the whole state (including that of this class), \c false if not supported
+    bool checkpoint(std::ostream& o) const
+    {
+        savebinary(o,finterval);
+        savebinary(o,flastlearningstart);
+        savebinary(o,flastlearningend);
+        return savestate(o);
+    }
+
+    /// restores the state saved by marketsim::teventdrivenstrategy::checkpoint
+    void restore(std::istream& i)
+    {
+        loadbinary(i,finterval);
+        loadbinary(i,flastlearningstart);
+        loadbinary(i,flastlearningend);
+        restorestate(i);
+    }
+
     /// implemented for the strategy being runable RT
     virtual void trade(twallet) override
     {
@@ -2344,8 +2597,8 @@ private:
     }
     double finterval;
 
-    tabstime flastlearningstart;
-    tabstime flastlearningend;
+    tabstime flastlearningstart = 0;
+    tabstime flastlearningend = 0;
 };
 
 
@@ -2373,37 +2626,157 @@ public:
     void seed(unsigned i)
     {
         fengine.seed(i);
+        fseed = i;
     }
 private:
 
     friend class tstrategy;
     friend class tdsbase;
 
+    /// generator seeded by the seed of the market and \p stream, \p index
+    /// (see marketsim::tmarketdef::independentrandomstreams)
+    std::default_random_engine derivedengine(unsigned stream, unsigned index) const
+    {
+        std::seed_seq s{fseed, stream, index};
+        std::default_random_engine e;
+        e.seed(s);
+        return e;
+    }
+
+    /// generator of the demand and supply
+    std::default_random_engine& dsengine()
+    {
+        return fdef.independentrandomstreams ? fdsengine : fengine;
+    }
+
     /// converts a strategy \p id  to its index in marketsim::tmarketdata
-    int findstrategy(const tstrategyid id)
+    int findstrategy(const tstrategyid id) const
     {
         assert(fmarketdata);
-        for(unsigned i=0; i<fmarketdata->fstrategyinfos.size(); i++)
-            if(id == fmarketdata->fstrategyinfos[i].strategyid())
-                return i;
+        unsigned k = id - ffirstid;
+        if(id >= ffirstid && k < findices.size() && findices[k] >= 0)
+            return findices[k];
         throw marketsimerror("Internal error: cannot assign owner");
     }
 
-    std::string findname(const tstrategyid id)
+    const std::string& findname(const tstrategyid id) const
     {
-        assert(fmarketdata);
-        for(unsigned i=0; i<fmarketdata->fstrategyinfos.size(); i++)
-            if(id == fmarketdata->fstrategyinfos[i].strategyid())
-                return fmarketdata->fstrategyinfos[i].name();
-        throw marketsimerror("Internal error: cannot assign name");
+        return fmarketdata->fstrategyinfos[findstrategy(id)].name();
+    }
+
+    /// assigns indices to \p strategies (in the order they are passed to marketsim::tmarket::run)
+    /// and prepares marketsim::tmarket::findstrategy, marketsim::tmarket::flogged and the lists
+    /// of the strategies accepting demand and supply
+    void indexstrategies(const std::vector<tstrategy*>& strategies)
+    {
+        findices.clear();
+        flogged.assign(strategies.size(),false);
+        fdemandrecipients.clear();
+        fsupplyrecipients.clear();
+        for(unsigned i=0; i<strategies.size(); i++)
+        {
+            if(strategies[i]->acceptsdemand())
+                fdemandrecipients.push_back(i);
+            if(strategies[i]->acceptssupply())
+                fsupplyrecipients.push_back(i);
+        }
+        if(strategies.empty())
+            return;
+        auto minmax = std::minmax_element(strategies.begin(), strategies.end(),
+               [](const tstrategy* a, const tstrategy* b) { return a->fid < b->fid; });
+        ffirstid = (*minmax.first)->fid;
+        findices.assign((*minmax.second)->fid - ffirstid + 1, -1);
+        for(unsigned i=0; i<strategies.size(); i++)
+        {
+            strategies[i]->findex = i;
+            findices[strategies[i]->fid - ffirstid] = i;
+        }
+        for(auto i: fdef.loggedstrategies)
+            if(i < flogged.size())
+                flogged[i] = true;
+    }
+
+    /// state of an ED event evaluated on a thread of marketsim::tmarket::fedpool
+    struct tparallelevent
+    {
+        tabstime t;
+        double cpustart;
+        /// if not null, the random generator the event uses instead of the market's one
+        std::default_random_engine* engine = nullptr;
+    };
+
+    /// set while the calling thread evaluates an event of a parallel batch
+    static inline thread_local const tparallelevent* fparallelevent = nullptr;
+
+    /// ED with marketsim::tmarketdef::edoptimistic: an event evaluated speculatively
+    struct tspeculation
+    {
+        bool pending = false;
+        tabstime t;
+        /// marketsim::tmarketdata::fversion the event saw
+        unsigned long long version;
+        /// predicted state of the random generator at the start of the event
+        std::default_random_engine startengine;
+        /// state of the random generator after the event
+        std::default_random_engine engine;
+        /// checkpoint of the strategy before the event (empty if it could not be rolled back)
+        std::string state;
+        trequest request;
+        double dt;
+        std::exception_ptr err;
+    };
+
+    /// number of draws needed for random generator \p from to reach the state \p to
+    /// (0 if it is more than 256)
+    static unsigned enginesteps(std::default_random_engine from, const std::default_random_engine& to)
+    {
+        for(unsigned k=0; k<=256; k++, from())
+            if(from == to)
+                return k;
+        return 0;
+    }
+
+    /// duration of the current chronos tick in seconds
+    double currentticktime() const
+    {
+        return fdef.adaptivechronosduration
+            ? std::chrono::duration<double>(this->get_tick_duration()).count()
+            : fdef.ticktime();
+    }
+
+    /// number of (current) chronos ticks lasting \p t
+    chronos::app_time ticksfor(tabstime t) const
+    {
+        return t / currentticktime();
+    }
+
+    /// chronos time of absolute time \p t (with adaptive tick duration, estimated
+    /// by the current duration of the tick)
+    chronos::app_time chronostime(tabstime t)
+    {
+        if(!fdef.adaptivechronosduration)
+            return t / fdef.ticktime();
+        tabstime now = getabstime();
+        return this->get_time() + (t > now ? ticksfor(t - now) : 0);
     }
 
     /// used by (friend class) marketsim::tstrategy
     tabstime getabstime()
     {
-        return frunningwithchronos
-                ? this->get_time() * fdef.ticktime()
-                : fnonchronosstatreventtime + (::clock()-fclockstarteventtime) / CLOCKS_PER_SEC;
+        if(frunningwithchronos)
+            return fdef.adaptivechronosduration
+                ? std::chrono::duration<double>(this->get_elapsed()).count()
+                : this->get_time() * fdef.ticktime();
+        else if(fparallelevent)
+            return fparallelevent->t + fdef.comptimemodel.charge(edclock() - fparallelevent->cpustart);
+        else
+            return fnonchronosstatreventtime + fdef.comptimemodel.charge(edclock() - fclockstarteventtime);
+    }
+
+    /// reads the clock measuring computation times in ED (tmarketdef::comptimeclock)
+    double edclock() const
+    {
+        return clocktime(fdef.comptimeclock);
     }
 
     /// used by (friend class) marketsim::tstrategy
@@ -2442,7 +2815,9 @@ private:
                            fmarketdata->fstrategyinfos,
                            owner,
                            fmarketdata->ftimestamp++,
-                           st);
+                           st,
+                           fcollectors);
+            fmarketdata->fversion++;
             if(islogging())
             {
                 std::ostringstream s;
@@ -2458,7 +2833,10 @@ private:
                 possiblylog(floggingfilter.fsettle,0,s.str(), s2.str());
             }
             auto profile = ob.obprofile();
-            fmarketdata->fhistory.add(tsnapshot(ob.b(),ob.a(),st,sr.q,profile.B.volume(),profile.A.volume()));
+            tsnapshot snapshot(ob.b(),ob.a(),st,sr.q,profile.B.volume(),profile.A.volume());
+            fmarketdata->fhistory.add(snapshot);
+            for(auto c: fcollectors)
+                c->settle(owner,snapshot);
             return sr;
 
         }
@@ -2498,6 +2876,8 @@ private:
         assert(fmarketdata);
         setsnapshot();
         fmarketdata->fextraduration.add(get_remaining_time().count());
+        for(auto c: fcollectors)
+            c->tick(getabstime());
         possiblylog(floggingfilter.ftick,0,"Tick called");
     }
 
@@ -2523,10 +2903,13 @@ public:
     /// \p maxtime - time of simulation in absolute time
     /// \p adef - paremeters of market
     tmarket(tabstime maxtime, tmarketdef adef) :
-        chronos::Chronos(adef.chronosduration, maxtime / adef.ticktime()),
+        chronos::Chronos(adef.chronosduration, maxtime / adef.ticktime(), adef.workerruntime),
         fdef(adef), fmaxtime(maxtime),
         flog(0)
     {
+        // the events evaluated against a frozen market must not shift each other's draws
+        if(fdef.edfrozenmarket && fdef.edthreads != 1 && !fdef.edoptimistic)
+            fdef.independentrandomstreams = true;
     }
 
     /// destructor
@@ -2570,6 +2953,58 @@ public:
         return fmarketdata;
     }
 
+    /// numbers of events of the last optimistic ED simulation (see marketsim::tmarketdef::edoptimistic)
+    /// whose speculative evaluations were committed and rolled back, respectively
+    struct tspeculationstats
+    {
+        unsigned long committed = 0;
+        unsigned long rolledback = 0;
+    };
+
+    /// accessor
+    const tspeculationstats& speculationstats() const
+    {
+        return fspeculationstats;
+    }
+
+    /// ED only: the next run writes a checkpoint of the simulation (the market data, the states
+    /// of the strategies and of the demand/supply generator, the random generator and the pending
+    /// events) to binary stream \p o once its time reaches \p t (or at its end, if sooner). The
+    /// strategies and the generator have to support checkpoints (see
+    /// marketsim::teventdrivenstrategy::savestate and marketsim::tdsbase::savestate).
+    void checkpointto(std::ostream& o, tabstime t)
+    {
+        fcheckpointout = &o;
+        fcheckpointtime = t;
+    }
+
+    /// ED only: the next run resumes the simulation from the checkpoint read from binary stream
+    /// \p i (written by marketsim::tmarket::checkpointto) instead of starting it anew. The run has
+    /// to be called with the same competitors (the endowments are then ignored). If
+    /// \p restorerandom is \c false, the random generator keeps its current state (see
+    /// marketsim::tmarket::seed), so the runs resumed from the same checkpoint differ.
+    void restorefrom(std::istream& i, bool restorerandom = true)
+    {
+        frestorein = &i;
+        frestorerandom = restorerandom;
+    }
+
+    /// the following runs notify \p c of their events (see marketsim::tmetriccollector),
+    /// \p c has to outlive them. With checkpoints, \p c has to support them and the
+    /// resumed run has to have the same collectors.
+    void addcollector(tmetriccollector* c)
+    {
+        assert(c);
+        fcollectors.push_back(c);
+    }
+
+    /// returns Chronos telemetry of the last RT simulation (tick durations, queue of
+    /// requests, wake-up latencies and time spent in requests of individual strategies)
+    const chronos::Telemetry& telemetry() const
+    {
+        return get_telemetry();
+    }
+
     /// Run the simulation for stregeties in RT (\tparam chronos == \c true) or ED (\tparam chronos == \c false).
     /// The compening strategies are those associated with \p competitors,
     /// having \p endowments. The parameter \p garbage is needed for technical reasons,
@@ -2585,6 +3020,10 @@ public:
         if(islogging() && fdef.directlogging)
             *flog << flogheader << std::endl;
         frunningwithchronos = chronos;
+        std::ostream* checkpointout = fcheckpointout;
+        std::istream* restorein = frestorein;
+        fcheckpointout = nullptr;
+        frestorein = nullptr;
         possiblylog(true,0,"Starting simulation");
         if(fdef.directlogging)
             possiblylog(true,0,"Direct logging","Only entries by fmarket are logged due to thread safety.");
@@ -2610,6 +3049,9 @@ public:
         }
         ds->fmarket = this;
         fmarketdata.reset(new tmarketdata(endowments,strategies,ds,names));
+        for(auto c: fcollectors)
+            c->start(*fmarketdata,fmaxtime);
+        indexstrategies(strategies);
         setsnapshot();
         chronos::workers_list wl;
         unsigned i=0;
@@ -2621,13 +3063,57 @@ public:
             if(!(competitors[i]->startswithoutwarmup()))
                 strategies[i]->fwarmingtime += fdef.warmuptime;
         }
+        fstrategyengines.clear();
+        fnoiseengines.clear();
+        if(fdef.independentrandomstreams)
+        {
+            fdsengine = derivedengine(0,0);
+            for(unsigned i=0; i<strategies.size(); i++)
+            {
+                fstrategyengines.push_back(derivedengine(1,i));
+                fnoiseengines.push_back(derivedengine(2,i));
+            }
+        }
         bool waserror = true;
         std::string errtxt;
         try
         {
             if constexpr(chronos)
             {
-                chronos::Chronos::run(wl);
+                if(checkpointout || restorein)
+                    throw marketsimerror("Checkpoints are supported only by the ED simulation");
+                if(fdef.adaptivechronosduration)
+                {
+                    set_adaptive_duration(fdef.minchronosduration, fdef.maxchronosduration);
+                    set_max_time(0);
+                    set_max_elapsed(std::chrono::duration_cast<chronos::app_duration>(
+                                        std::chrono::duration<double>(fmaxtime)));
+                }
+                set_wait_policy(fdef.waitpolicy);
+                set_cpu(fdef.chronoscpu);
+                set_async_budget(fdef.asyncbudget);
+                std::ofstream journalout;
+                if(fdef.journalrecordfile.size())
+                {
+                    journalout.open(fdef.journalrecordfile, std::ios::binary);
+                    if(!journalout)
+                        throw marketsimerror("Cannot open " + fdef.journalrecordfile);
+                }
+                set_journal_output(journalout.is_open() ? &journalout : nullptr);
+                if(fdef.journalreplayfile.size())
+                {
+                    std::ifstream journalin(fdef.journalreplayfile, std::ios::binary);
+                    if(!journalin)
+                        throw marketsimerror("Cannot open " + fdef.journalreplayfile);
+                    set_journal_input(journalin);
+                }
+                if(fdef.executor)
+                    fdef.executor->run(*this,wl);
+                else
+                    chronos::Chronos::run(wl);
+                set_journal_output(nullptr);
+                if(get_replay_diverged())
+                    possiblylog(true,0,"run diverged from " + fdef.journalreplayfile);
             }
             else
             {
@@ -2641,82 +3127,346 @@ public:
                     ts.push_back(strategies[i]->fwarmingtime);
                 std::vector<tabstime> rts(n,std::numeric_limits<tabstime>::max());
                 std::vector<trequest> rs(n);
-                tabstime dst = fdef.demandupdateperiod;
-                for(;;)
+                tabstime dst = fmarketdata->fds->nextarrival(0);
+
+                teventqueue q(n);
+                for(unsigned i=0; i<n; i++)
+                    q.set(teventqueue::eventid(i),ts[i]);
+                q.set(q.dsid(),dst);
+
+                fedpool.reset();
+                // the parallel simulation speculates (and rolls back), so it is serial
+                // in effect and draws from the generators in the serial order
+                bool optimistic = fdef.edthreads != 1 && !islogging();
+                // see marketsim::tmarketdef::edfrozenmarket
+                bool frozen = optimistic && fdef.edfrozenmarket && !fdef.edoptimistic;
+                bool independent = fdef.independentrandomstreams;
+                if(optimistic)
+                    fedpool.reset(new tworkstealingpool(fdef.edthreads));
+                if(frozen && checkpointout)
+                    throw marketsimerror("Checkpoints are not supported with edfrozenmarket");
+                std::vector<tspeculation> speculations(optimistic ? n : 0);
+                // draws from the random generator by the last event of each strategy
+                std::vector<unsigned> draws(n,0);
+                fspeculationstats = tspeculationstats();
+
+                // bookkeeping after event of strategy \p i called at \p t computed for \p dt
+                auto eventfinished = [&](unsigned i, tabstime t, double dt)
                 {
-                    unsigned first;
-                    bool isevent;
-                    tabstime t = std::numeric_limits<tabstime>::max();
-                    for(unsigned i=0; i<n; i++)
+                    teventdrivenstrategy* str = (static_cast<teventdrivenstrategy*>(strategies[i]));
+                    if constexpr(allowlearning)
                     {
-                        if(ts[i] <= t)
+                        if(str->flastlearningstart >= t && str->flastlearningend > str->flastlearningstart)
                         {
-                            t = ts[i];
-                            first = i;
-                            isevent = true;
+                            assert(str->flastlearningend <= t+dt);
+                            dt -= str->flastlearningend - str->flastlearningstart;
+                            assert(dt >= 0);
                         }
-                        if(rts[i] <= t)
+                    }
+
+                    fmarketdata->fstrategyinfos[i].addcomptime(dt);
+                    double noise = independent ? funiform(fnoiseengines[i]) : str->uniform();
+                    ts[i] = t + std::max(dt,str->finterval) + def().ticktime()
+                                          + noise * def().epsilon;
+                    rts[i] = t + dt;
+                    q.set(teventqueue::eventid(i),ts[i]);
+                    q.set(teventqueue::requestid(i),rts[i]);
+// std::cout << " calling event of strategy " << i << std::fixed << " at " << t  << "s took " << dt << "s" << std::endl;
+                    if(islogging())
+                    {
+                        std::ostringstream s;
+                        s << "duration " << dt;
+                        possiblylog(floggingfilter.frequest,str->fid,"event (non-chronos)",s.str());
+                    }
+
+                    firsttime[i] = false;
+                };
+
+                // evaluates event of strategy \p i called at \p t
+                auto serialevent = [&](unsigned i, tabstime t)
+                {
+                    teventdrivenstrategy* str = (static_cast<teventdrivenstrategy*>(strategies[i]));
+                    auto info = str->internalgetinfo<false>();
+                    fclockstarteventtime = edclock();
+                    fnonchronosstatreventtime = t;
+
+                    rs[i] = str->event(info,t,firsttime[i] ? 0 : &(results[i]));
+
+                    double dt = fdef.comptimemodel.charge(edclock() - fclockstarteventtime);
+                    eventfinished(i,t,dt);
+                };
+
+                // evaluates speculatively the top event and the events following it
+                // until the next request or demand/supply event (optimistic ED)
+                // gives up the speculative evaluations not reached yet (optimistic ED)
+                auto abandonspeculations = [&]()
+                {
+                    // the events against the frozen market are committed when reached
+                    if(frozen)
+                        return;
+                    for(unsigned i=0; i<speculations.size(); i++)
+                        if(speculations[i].pending)
                         {
-                            t = rts[i];
-                            first = i;
-                            isevent = false;
+                            assert(speculations[i].state.size());
+                            std::istringstream is(speculations[i].state);
+                            static_cast<teventdrivenstrategy*>(strategies[i])->restore(is);
+                            speculations[i].pending = false;
+                            fspeculationstats.rolledback++;
                         }
+                };
+
+                // see marketsim::tmarket::checkpointto
+                auto savecheckpoint = [&](std::ostream& o)
+                {
+                    abandonspeculations();
+                    o.write(fcheckpointmagic, sizeof(fcheckpointmagic));
+                    savebinary(o,static_cast<unsigned>(n));
+                    for(unsigned i=0; i<n; i++)
+                        savebinary(o,names[i]);
+                    fmarketdata->save(o);
+                    if(!fmarketdata->fds->savestate(o))
+                        throw marketsimerror("Demand/supply generator does not support checkpoints");
+                    for(unsigned i=0; i<n; i++)
+                        if(!static_cast<teventdrivenstrategy*>(strategies[i])->checkpoint(o))
+                            throw marketsimerror("Strategy " + names[i] + " does not support checkpoints");
+                    savebinary(o,firsttime);
+                    for(unsigned i=0; i<n; i++)
+                    {
+                        results[i].save(o);
+                        rs[i].save(o);
                     }
-                    bool dsevent;
-                    if(dst < t)
-                        dsevent = true;
-                    else
-                        dsevent = false;
+                    savebinary(o,ts);
+                    savebinary(o,rts);
+                    savebinary(o,dst);
+                    savetext(o,fengine);
+                    savebinary(o,static_cast<unsigned>(fstrategyengines.size()));
+                    for(const auto& e: fstrategyengines)
+                        savetext(o,e);
+                    savebinary(o,static_cast<unsigned>(fnoiseengines.size()));
+                    for(const auto& e: fnoiseengines)
+                        savetext(o,e);
+                    savetext(o,fdsengine);
+                    savebinary(o,static_cast<unsigned>(fcollectors.size()));
+                    for(auto c: fcollectors)
+                        if(!c->savestate(o))
+                            throw marketsimerror("Metric collector does not support checkpoints");
+                    if(!o)
+                        throw marketsimerror("Cannot write checkpoint");
+                };
+
+                // see marketsim::tmarket::restorefrom
+                auto loadcheckpoint = [&](std::istream& is)
+                {
+                    char magic[sizeof(fcheckpointmagic)];
+                    unsigned m = 0;
+                    if(!is.read(magic, sizeof(magic))
+                            || !std::equal(magic, magic + sizeof(magic), fcheckpointmagic))
+                        throw marketsimerror("Not a marketsim checkpoint");
+                    loadbinary(is,m);
+                    if(m != n)
+                        throw marketsimerror("Checkpoint has a different number of strategies");
+                    for(unsigned i=0; i<n; i++)
+                    {
+                        std::string name;
+                        loadbinary(is,name);
+                        if(name != names[i])
+                            throw marketsimerror("Checkpoint of different strategies (" + name + ")");
+                    }
+                    fmarketdata->load(is);
+                    fmarketdata->fds->restorestate(is);
+                    for(unsigned i=0; i<n; i++)
+                        static_cast<teventdrivenstrategy*>(strategies[i])->restore(is);
+                    std::vector<bool> ft;
+                    loadbinary(is,ft);
+                    firsttime = ft;
+                    for(unsigned i=0; i<n; i++)
+                    {
+                        results[i].load(is);
+                        rs[i].load(is);
+                    }
+                    loadbinary(is,ts);
+                    loadbinary(is,rts);
+                    loadbinary(is,dst);
+                    std::default_random_engine e;
+                    loadtext(is,e);
+                    if(frestorerandom)
+                        fengine = e;
+                    loadbinary(is,m);
+                    for(unsigned i=0; i<m; i++)
+                    {
+                        loadtext(is,e);
+                        if(m == fstrategyengines.size() && frestorerandom)
+                            fstrategyengines[i] = e;
+                    }
+                    loadbinary(is,m);
+                    for(unsigned i=0; i<m; i++)
+                    {
+                        loadtext(is,e);
+                        if(m == fnoiseengines.size() && frestorerandom)
+                            fnoiseengines[i] = e;
+                    }
+                    loadtext(is,e);
+                    if(frestorerandom)
+                        fdsengine = e;
+                    loadbinary(is,m);
+                    if(m != fcollectors.size())
+                        throw marketsimerror("Checkpoint has a different number of metric collectors");
+                    for(auto c: fcollectors)
+                        c->restorestate(is);
+                    if(!is || ts.size() != n || rts.size() != n)
+                        throw marketsimerror("Corrupted checkpoint");
+                    for(unsigned i=0; i<n; i++)
+                    {
+                        q.set(teventqueue::eventid(i),ts[i]);
+                        q.set(teventqueue::requestid(i),rts[i]);
+                    }
+                    q.set(q.dsid(),dst);
+                };
+
+                auto speculate = [&]()
+                {
+                    // the evaluations of the previous batch not reached yet are given up
+                    abandonspeculations();
 
+                    tabstime horizon = std::min(dst, T);
+                    q.foreachuntil(horizon, [&](unsigned id)
+                    {
+                        if(q.isrequest(id))
+                            horizon = std::min(horizon, q.time(id));
+                    });
+                    // without edoptimistic only the events within the window are evaluated
+                    tabstime windowend = fdef.edoptimistic ? horizon
+                                          : q.time(q.top()) + fdef.edparallelwindow;
+                    std::vector<unsigned> order;
+                    q.foreachuntil(horizon, [&](unsigned id)
+                    {
+                        if(!q.isrequest(id) && !q.isds(id)
+                             && ((q.time(id) < horizon && q.time(id) <= windowend)
+                                  || id == q.top()))
+                            order.push_back(id);
+                    });
+                    std::sort(order.begin(), order.end(), [&q](unsigned a, unsigned b)
+                         { return q.before(a,b); });
+
+                    unsigned depth = frozen ? order.size()
+                        : fdef.edspeculationdepth ? fdef.edspeculationdepth : 2*fedpool->size();
+                    std::default_random_engine e = fengine;
+                    std::vector<unsigned> batch;
+                    std::vector<tmarketinfo> infos;
+                    for(unsigned k=0; k<order.size() && batch.size() < depth; k++)
+                    {
+                        unsigned i = teventqueue::strategy(order[k]);
+                        teventdrivenstrategy* s = (static_cast<teventdrivenstrategy*>(strategies[i]));
+                        tspeculation& sp = speculations[i];
+                        // (evaluated within the previous window)
+                        if(frozen && sp.pending)
+                            continue;
+                        if(independent)
+                            sp.startengine = fstrategyengines[i];
+                        else
+                        {
+                            sp.startengine = e;
+                            // (including the epsilon noise drawn after the event)
+                            e.discard(draws[i]);
+                        }
+                        std::ostringstream o;
+                        // the first event is always valid, those against the frozen market too
+                        if(k > 0 && !frozen && !s->checkpoint(o))
+                            continue;
+                        sp.pending = true;
+                        sp.t = ts[i];
+                        sp.version = fmarketdata->fversion;
+                        sp.state = o.str();
+                        sp.err = nullptr;
+                        batch.push_back(i);
+                        infos.push_back(s->internalgetinfo<false>());
+                    }
 
-                    if(t >= T)
+                    std::vector<std::function<void()>> tasks;
+                    for(unsigned k=0; k<batch.size(); k++)
+                        tasks.push_back([&,k]()
+                        {
+                            unsigned i = batch[k];
+                            teventdrivenstrategy* s = (static_cast<teventdrivenstrategy*>(strategies[i]));
+                            tspeculation& sp = speculations[i];
+                            sp.engine = sp.startengine;
+                            tparallelevent pe = { sp.t, edclock(), &sp.engine };
+                            fparallelevent = &pe;
+                            try
+                            {
+                                sp.request = s->event(infos[k],sp.t,firsttime[i] ? 0 : &(results[i]));
+                            }
+                            catch (...)
+                            {
+                                sp.err = std::current_exception();
+                            }
+                            sp.dt = fdef.comptimemodel.charge(edclock() - pe.cpustart);
+                            fparallelevent = nullptr;
+                        });
+                    fedpool->run(tasks);
+                };
+
+                if(restorein)
+                    loadcheckpoint(*restorein);
+                for(;;)
+                {
+                    unsigned top = q.top();
+                    // ends once no strategy has anything to do before T
+                    bool finished = (q.isds(top) ? q.secondtime() : q.time(top)) >= T;
+                    if(checkpointout && (finished || q.time(top) >= fcheckpointtime))
+                    {
+                        savecheckpoint(*checkpointout);
+                        checkpointout = nullptr;
+                    }
+                    if(finished)
                         break;
-//std::cout << "t=" << t << ", dst=" << dst << std::endl;
-                    if(dsevent)
+                    tabstime now = q.time(top);
+//std::cout << "t=" << q.time(top) << ", dst=" << dst << std::endl;
+                    if(q.isds(top))
                     {
                         auto ds = fmarketdata->fds->delta(dst, *fmarketdata.get() );
-                        distributeds(ds,strategies,dst);
-                        dst += fdef.demandupdateperiod;
+                        distributeds(ds,dst);
+                        dst = fmarketdata->fds->nextarrival(dst);
+                        q.set(q.dsid(),dst);
                     }
                     else
                     {
+                        unsigned first = teventqueue::strategy(top);
+                        bool isevent = !q.isrequest(top);
+                        tabstime t = q.time(top);
                         teventdrivenstrategy* str = (static_cast<teventdrivenstrategy*>(strategies[first]));
 
-                        if(isevent)
+                        if(isevent && optimistic)
                         {
-                           auto info = str->internalgetinfo<false>();
-                           fclockstarteventtime = clock();
-                           fnonchronosstatreventtime = t;
-
-                           rs[first] = str->event(info,t,firsttime[first] ? 0 : &(results[first]));
-
-//                           double endt = ;
-                           double dt = (::clock()-fclockstarteventtime) / CLOCKS_PER_SEC;
-
-                           if constexpr(allowlearning)
-                           {
-                               if(str->flastlearningstart >= t && str->flastlearningend > str->flastlearningstart)
-                               {
-                                   assert(str->flastlearningend <= t+dt);
-                                   dt -= str->flastlearningend - str->flastlearningstart;
-                                   assert(dt >= 0);
-                               }
-                           }
-
-                           fmarketdata->fstrategyinfos[first].addcomptime(dt);
-                           ts[first] = t + std::max(dt,str->finterval) + def().ticktime()
-                                                 + str->uniform() * def().epsilon;
-                           rts[first] = t + dt;
-    // std::cout << " calling event of strategy " << first << std::fixed << " at " << t  << "s took " << dt << "s" << std::endl;
-                           if(islogging())
-                           {
-                               std::ostringstream s;
-                               s << "duration " << dt;
-                               possiblylog(floggingfilter.frequest,str->fid,"event (non-chronos)",s.str());
-                           }
-
-                           firsttime[first] = false;
+                            if(!speculations[first].pending)
+                                speculate();
+                            tspeculation& sp = speculations[first];
+                            sp.pending = false;
+                            auto& engine = independent ? fstrategyengines[first] : fengine;
+                            std::default_random_engine e0 = engine;
+                            // valid if neither the market nor the random generator changed since
+                            if(frozen || (sp.t == t && sp.version == fmarketdata->fversion
+                                            && sp.startengine == engine))
+                            {
+                                if(sp.err)
+                                    std::rethrow_exception(sp.err);
+                                engine = sp.engine;
+                                rs[first] = sp.request;
+                                eventfinished(first,t,sp.dt);
+                                fspeculationstats.committed++;
+                            }
+                            else
+                            {
+                                assert(sp.state.size());
+                                std::istringstream i(sp.state);
+                                str->restore(i);
+                                serialevent(first,t);
+                                fspeculationstats.rolledback++;
+                            }
+                            draws[first] = enginesteps(e0,engine);
                         }
+                        else if(isevent)
+                            serialevent(first,t);
                         else
                         {
                             if(islogging())
@@ -2726,9 +3476,12 @@ public:
 
                            results[first]=str->internalrequest<false>(rs[first],t);
                            rts[first] = std::numeric_limits<tabstime>::max();
+                           q.set(teventqueue::requestid(first),rts[first]);
                            setsnapshot();
                         }
                     } // dsevent
+                    for(auto c: fcollectors)
+                        c->tick(now);
                 }
                 for(unsigned i=0; i<n; i++)
                 {
@@ -2757,11 +3510,20 @@ public:
             errtxt = "run throwed unknown error.";
         }
 
+        for(auto c: fcollectors)
+            c->end(*fmarketdata);
+
         if(islogging() && fdef.loggingfilter.fprotocol)
         {
             fmarketdata->protocol(*flog,fmaxtime,fdef.numsnapshotsinprotocol);
         }
 
+        if(chronos && islogging() && fdef.loggingfilter.ftelemetry)
+        {
+            *flog << std::endl << "Chronos telemetry" << std::endl;
+            get_telemetry().dump(*flog);
+        }
+
         if(islogging() && !fdef.directlogging)
         {
             *flog << flogheader << std::endl;
@@ -2832,6 +3594,45 @@ private:
     double fclockstarteventtime;
     tabstime fnonchronosstatreventtime;
 
+    /// ED with marketsim::tmarketdef::edthreads other than 1: the pool evaluating events
+    std::unique_ptr<tworkstealingpool> fedpool;
+    /// ED with marketsim::tmarketdef::edthreads other than 1 or with
+    /// marketsim::tmarketdef::independentrandomstreams: random generators of
+    /// individual strategies (by index)
+    std::vector<std::default_random_engine> fstrategyengines;
+    /// with marketsim::tmarketdef::independentrandomstreams: generators of the noise
+    /// of the times of events of individual strategies
+    std::vector<std::default_random_engine> fnoiseengines;
+    /// with marketsim::tmarketdef::independentrandomstreams: generator of demand and supply
+    std::default_random_engine fdsengine;
+    /// the last seed passed to marketsim::tmarket::seed
+    unsigned fseed = std::default_random_engine::default_seed;
+    /// ED with marketsim::tmarketdef::edoptimistic
+    tspeculationstats fspeculationstats;
+    /// see marketsim::tmarket::checkpointto
+    std::ostream* fcheckpointout = nullptr;
+    tabstime fcheckpointtime = 0;
+    /// see marketsim::tmarket::addcollector
+    std::vector<tmetriccollector*> fcollectors;
+    /// see marketsim::tmarket::restorefrom
+    std::istream* frestorein = nullptr;
+    bool frestorerandom = true;
+    /// header of checkpoints (the last byte is the version)
+    static constexpr char fcheckpointmagic[5] = {'M','S','C','K',4};
+    /// serializes log entries of concurrently running events/strategies
+    std::mutex flogmutex;
+
+    /// indices of the strategies of the current run by their ids (less marketsim::tmarket::ffirstid),
+    /// -1 for ids of no strategy of the run
+    std::vector<int> findices;
+    tstrategyid ffirstid = 0;
+    /// \c true for the strategies whose custom entries are logged (see marketsim::tmarketdef::loggedstrategies)
+    std::vector<bool> flogged;
+    /// indices of the strategies accepting demand
+    std::vector<unsigned> fdemandrecipients;
+    /// indices of the strategies accepting supply
+    std::vector<unsigned> fsupplyrecipients;
+
     /// method routinely called on potential logging
     void possiblylog(bool doit, tstrategyid owner, const std::string&
                  shortmsg, const std::string& longmsg = "")
@@ -2840,6 +3641,7 @@ private:
         {
             if(fdef.directlogging && frunningwithchronos && owner != nostrategy)
                 return;
+            std::lock_guard<std::mutex> lock(flogmutex);
             int sn = owner != nostrategy ? findstrategy(owner) : 0;
             assert(sn < fmarketdata->fstrategyinfos.size());
             std::ostream& o = fdef.directlogging ? *flog ://std::cout;
@@ -2886,73 +3688,41 @@ private:
             o << std::endl;
         }
     }
-    void distributeds(const tdsrecord& ds, const std::vector<tstrategy*> strategies, tabstime t)
+    /// chooses at random the strategy (among \p recipients) receiving \p amount of \p what
+    unsigned choosedsrecipient(const std::vector<unsigned>& recipients, const std::string& what,
+                               tvolume amount)
+    {
+        if(recipients.empty())
+            throw marketsimerror("No strategy to pass " + what + " to");
+        unsigned owner = recipients[static_cast<unsigned>(recipients.size()*uniform())];
+        if(islogging())
+        {
+            std::ostringstream s1;
+            s1 << what << " distributed to " << fmarketdata->fstrategyinfos[owner].name();
+            std::ostringstream s2;
+            s2 << what << ": " << amount;
+            possiblylog(floggingfilter.fds,0,s1.str(),s2.str());
+        }
+        return owner;
+    }
+
+    /// passes the demand and the supply \p ds arriving at \p t to strategies accepting them
+    void distributeds(const tdsrecord& ds, tabstime t)
     {
+        fmarketdata->fversion++;
         if(ds.d > 0)
         {
-            unsigned numd = 0;
-            for(unsigned i=0; i< strategies.size(); i++)
-                if(strategies[i]->acceptsdemand())
-                    numd++;
-            if(numd > 0)
-            {
-                unsigned theone = numd*uniform();
-                for(unsigned i=0; i< strategies.size(); i++)
-                {
-                    if(strategies[i]->acceptsdemand())
-                    {
-                        if(theone==0)
-                        {
-                            int owner = findstrategy(strategies[i]->fid);
-                            std::ostringstream s1;
-                            s1 << "Demand distributed to " << findname(strategies[i]->fid);
-                            std::ostringstream s2;
-                            s2 << "Demand: " << ds.d;
-
-                            possiblylog(floggingfilter.fds,0,s1.str(),s2.str());
-                            fmarketdata->fstrategyinfos[owner].addds(ds.d,0,t);
-                            break;
-                        }
-                        else
-                            theone--;
-                    }
-                }
-            }
-            else
-                throw marketsimerror("No strategy to pass demand to");
+            auto i = choosedsrecipient(fdemandrecipients,"Demand",ds.d);
+            fmarketdata->fstrategyinfos[i].addds(ds.d,0,t);
+            for(auto c: fcollectors)
+                c->ds(i,ds.d,0,t);
         }
-        if(ds.s>0)
+        if(ds.s > 0)
         {
-            unsigned nums = 0;
-            for(unsigned i=0; i< strategies.size(); i++)
-                if(strategies[i]->acceptssupply())
-                    nums++;
-            if(nums > 0)
-            {
-                unsigned theone = nums*uniform();
-                for(unsigned i=0; i< strategies.size(); i++)
-                {
-                    if(strategies[i]->acceptssupply())
-                    {
-                        if(theone==0)
-                        {
-                            int owner = findstrategy(strategies[i]->fid);
-                            std::ostringstream s1;
-                            s1 << "Supply distributed to " << findname(strategies[i]->fid);
-                            std::ostringstream s2;
-                            s2 << "Supply: " << ds.s;
-
-                            possiblylog(floggingfilter.fds,0,s1.str(),s2.str());
-                            fmarketdata->fstrategyinfos[owner].addds(0,ds.s,t);
-                            break;
-                        }
-                        else
-                            theone--;
-                    }
-                }
-            }
-            else
-                throw marketsimerror("No strategy to pass demand to");
+            auto i = choosedsrecipient(fsupplyrecipients,"Supply",ds.s);
+            fmarketdata->fstrategyinfos[i].addds(0,ds.s,t);
+            for(auto c: fcollectors)
+                c->ds(i,0,ds.s,t);
         }
     }
 
@@ -2988,6 +3758,13 @@ public:
         return ret;
     }
 
+protected:
+    /// saves the state of this class, to be called by marketsim::teventdrivenstrategy::savestate
+    /// of descendants
+    void savedsstate(std::ostream& o) const { savebinary(o,flastdssize); }
+    /// restores the state saved by marketsim::tdsprocessingstrategy::savedsstate
+    void restoredsstate(std::istream& i) { loadbinary(i,flastdssize); }
+
 private:
     int flastdssize;
 
@@ -3005,7 +3782,7 @@ inline void tstrategy::main()
     catch (chronos::error_already_finished)
     {
         fmarket->possiblylog(true,fid, "stopped: already finished");
-        if(fmarket->get_time() < fmarket->get_max_time()-1)
+        if(fmarket->getabstime() < fmarket->fmaxtime - fmarket->currentticktime())
             throw;
         else
             return;
@@ -3035,6 +3812,61 @@ inline void tstrategy::main()
 }
 
 
+inline trequesthandle tstrategy::requestasync(const trequest& request)
+{
+    assert(fmarket);
+    try
+    {
+        if(request.empty())
+        {
+            std::promise<trequestresult> p;
+            p.set_value(trequestresult());
+            return trequesthandle(p.get_future(),nullptr);
+        }
+        if(fmarket->islogging())
+        {
+            std::ostringstream s;
+            request.output(s);
+            fmarket->possiblylog(fmarket->floggingfilter.frequest,fid,"requestasync called",s.str());
+        }
+        return fmarket->submit([this,request]()
+        {
+            trequestresult ret = this->fmarket->settle<true>(this->fid,request);
+            if(fmarket->islogging())
+            {
+                std::ostringstream s;
+                if(ret.errs.size()==0)
+                    s << "OK";
+                else
+                    for(unsigned i=0; i<ret.errs.size(); i++)
+                        s << ret.errs[i].text << ",";
+                fmarket->possiblylog(fmarket->floggingfilter.frequest,fid, "settle returned", s.str());
+            }
+            return ret;
+        });
+    }
+    catch (chronos::error_already_finished)
+    {
+        fmarket->possiblylog(true,fid, "requestasync throwed already finished");
+        throw;
+    }
+    catch (chronos::error& e)
+    {
+        fmarket->possiblylog(true,fid, "requestasync throwed chronos error", e.what());
+        throw;
+    }
+    catch (std::runtime_error& e)
+    {
+        fmarket->possiblylog(true,fid, "requestasync throwed error", e.what());
+        throw marketsimerror(e.what());
+    }
+    catch (...)
+    {
+        fmarket->possiblylog(true,fid, "requestasync throwed unknown error");
+        throw marketsimerror("requestasync throwed unknown error");
+    }
+}
+
 template <bool chronos>
 inline trequestresult tstrategy::internalrequest(const trequest& request, tabstime t)
 {
@@ -3147,7 +3979,7 @@ inline void tstrategy::sleepfor(tabstime t)
             s << "sleepfor(" << t << ") called";
             fmarket->possiblylog(fmarket->floggingfilter.fsleep, fid, s.str());
         }
-        sleep_until(fmarket->get_time() + t/fmarket->def().ticktime());
+        sleep_until(fmarket->get_time() + fmarket->ticksfor(t));
         fmarket->possiblylog(fmarket->floggingfilter.fsleep,fid, "sleepfor finished");
     }
     catch (chronos::error& e)
@@ -3178,7 +4010,7 @@ inline void tstrategy::sleepuntil(tabstime t)
             s << "sleepuntil(" << t << ") called";
             fmarket->possiblylog(fmarket->floggingfilter.fsleep,fid, s.str());
         }
-        sleep_until(t/fmarket->def().ticktime());
+        sleep_until(fmarket->chronostime(t));
         fmarket->possiblylog(fmarket->floggingfilter.fsleep,fid, "sleepuntil finished");
     }
     catch (chronos::error& e)
@@ -3234,13 +4066,17 @@ inline tabstime tstrategy::abstime()
 inline std::default_random_engine& tstrategy::engine()
 {
     assert(fmarket);
+    if(fmarket->fparallelevent && fmarket->fparallelevent->engine)
+        return *fmarket->fparallelevent->engine;
+    if(fmarket->fstrategyengines.size())
+        return fmarket->fstrategyengines[findex];
     return fmarket->fengine;
 }
 
 inline double tstrategy::uniform()
 {
     assert(fmarket);
-    return fmarket->funiform(fmarket->fengine);
+    return std::uniform_real_distribution<double>()(engine());
 }
 
 
@@ -3252,11 +4088,8 @@ inline bool tstrategy::endoftrading()
 inline void tstrategy::possiblylog(const std::string&
              shortmsg, const std::string& longmsg)
 {
-    auto f = fmarket->def().loggedstrategies;
-    auto ind = fmarket->findstrategy(fid);
-    for(unsigned i=0; i<f.size(); i++)
-        if(f[i]==ind)
-             fmarket->possiblylog(true, fid, shortmsg, longmsg);
+    if(findex < fmarket->flogged.size() && fmarket->flogged[findex])
+        fmarket->possiblylog(true, fid, shortmsg, longmsg);
 }
 
 
@@ -3292,7 +4125,8 @@ inline int tmarketdef::findduration(unsigned nstrategies, const tmarketdef& def,
             if(garbage.size()) /// tbd speciální výjimka
                 throw marketsimerror("Internal error: calibrating strategy unterminated.");
             double rem = m.results()->fextraduration.average();
-            log << "remaining = " << rem << std::endl;
+            log << "remaining = " << rem << " (5% quantile "
+                << m.results()->fextraduration.quantile(0.05) << ")" << std::endl;
             if(rem > 0)
                 break;
         }
@@ -3317,16 +4151,25 @@ inline int tmarketdef::findduration(unsigned nstrategies, const tmarketdef& def,
 inline std::default_random_engine& tdsbase::engine()
 {
     assert(fmarket);
-    return fmarket->fengine;
+    return fmarket->dsengine();
 }
 
 inline double tdsbase::uniform()
 {
     assert(fmarket);
-    return fmarket->funiform(fmarket->fengine);
+    return fmarket->funiform(fmarket->dsengine());
+}
+
+inline tabstime tdsbase::nextarrival(tabstime t)
+{
+    assert(fmarket);
+    return t + fmarket->def().demandupdateperiod;
 }
 
 
 } // namespace
 
+// defines marketsim::tmarketdata::protocol
+#include "marketsim/collectors.hpp"
+
 #endif // MARKETSIM_HPP
@@ -0,0 +1,162 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace marketsim
+{
+
+/// writes \p x (a trivially copyable value) to binary stream \p o
+template <typename T>
+inline void savebinary(std::ostream& o, const T& x)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    o.write(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+/// reads \p x written by marketsim::savebinary from binary stream \p i
+template <typename T>
+inline void loadbinary(std::istream& i, T& x)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    i.read(reinterpret_cast<char*>(&x), sizeof(T));
+}
+
+/// number of bytes left in binary stream \p i (the maximal value if the stream
+/// cannot tell, zero if it has failed)
+inline unsigned long long remainingbytes(std::istream& i)
+{
+    if(!i)
+        return 0;
+    auto pos = i.tellg();
+    if(pos == std::streampos(-1))
+        return std::numeric_limits<unsigned long long>::max();
+    i.seekg(0, std::ios::end);
+    auto end = i.tellg();
+    i.seekg(pos);
+    if(!i || end == std::streampos(-1))
+    {
+        i.clear();
+        i.seekg(pos);
+        return std::numeric_limits<unsigned long long>::max();
+    }
+    return end > pos ? static_cast<unsigned long long>(end - pos) : 0;
+}
+
+/// reads a length (of type \p N) written by marketsim::savebinary from binary stream \p i
+/// and checks that the stream has at least \p minsize times that many bytes left (if not,
+/// the stream is failed, so a corrupted length does not lead to a huge allocation)
+template <typename N = unsigned long long>
+inline N loadlength(std::istream& i, unsigned long long minsize)
+{
+    N n = 0;
+    loadbinary(i, n);
+    if(!i || (minsize && n > remainingbytes(i) / minsize))
+    {
+        i.setstate(std::ios::failbit);
+        return 0;
+    }
+    return n;
+}
+
+/// number of elements reserved at once when the length of the stream is unknown
+static constexpr unsigned long long kloadchunk = 1 << 16;
+
+/// writes string \p s (preceded by its length) to binary stream \p o
+inline void savebinary(std::ostream& o, const std::string& s)
+{
+    savebinary(o, static_cast<unsigned long long>(s.size()));
+    o.write(s.data(), s.size());
+}
+
+/// reads string \p s written by marketsim::savebinary from binary stream \p i
+inline void loadbinary(std::istream& i, std::string& s)
+{
+    unsigned long long n = loadlength(i, 1);
+    s.clear();
+    // read in chunks, so the string grows only as the data arrive
+    while(n && i)
+    {
+        auto k = std::min(n, kloadchunk);
+        auto old = s.size();
+        s.resize(old + k);
+        i.read(&s[old], k);
+        n -= k;
+    }
+}
+
+/// writes vector \p v (preceded by its length) to binary stream \p o
+template <typename T>
+inline void savebinary(std::ostream& o, const std::vector<T>& v)
+{
+    savebinary(o, static_cast<unsigned long long>(v.size()));
+    for(const auto& x: v)
+        savebinary(o, static_cast<const T&>(x));
+}
+
+/// reads a value written by marketsim::savebinary from binary stream \p i
+/// (unlike marketsim::loadbinary, also values without default constructors)
+template <typename T>
+inline T loadobject(std::istream& i)
+{
+    if constexpr(std::is_default_constructible<T>::value)
+    {
+        T x;
+        loadbinary(i, x);
+        return x;
+    }
+    else
+    {
+        static_assert(std::is_trivially_copyable<T>::value);
+        union tstorage
+        {
+            tstorage() {}
+            char c;
+            T x;
+        } s;
+        i.read(reinterpret_cast<char*>(&s.x), sizeof(T));
+        return s.x;
+    }
+}
+
+/// reads vector \p v written by marketsim::savebinary from binary stream \p i
+template <typename T>
+inline void loadbinary(std::istream& i, std::vector<T>& v)
+{
+    unsigned long long n = loadlength(i, 1);
+    v.clear();
+    v.reserve(std::min(n, kloadchunk));
+    for(unsigned long long k=0; k<n && i; k++)
+        v.push_back(loadobject<T>(i));
+}
+
+/// writes \p x by its stream operator (used for random engines and distributions, whose
+/// state is accessible only this way) to binary stream \p o
+template <typename T>
+inline void savetext(std::ostream& o, const T& x)
+{
+    std::ostringstream s;
+    s << x;
+    savebinary(o, s.str());
+}
+
+/// reads \p x written by marketsim::savetext from binary stream \p i
+template <typename T>
+inline void loadtext(std::istream& i, T& x)
+{
+    std::string s;
+    loadbinary(i, s);
+    std::istringstream is(s);
+    is >> x;
+}
+
+} // namespace
+
+#endif // CHECKPOINT_HPP
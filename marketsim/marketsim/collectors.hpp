@@ -0,0 +1,371 @@
+#ifndef COLLECTORS_HPP
+#define COLLECTORS_HPP
+
+#include "marketsim.hpp"
+
+namespace marketsim
+{
+
+/// marketsim::tmetriccollector of the scores of the competitions: the total consumptions
+/// of the strategies and the last defined price (see marketsim::tmarketdata::lastdefinedp)
+class tscorecollector : public tmetriccollector
+{
+public:
+    virtual void start(const tmarketdata& data, tabstime) override
+    {
+        fconsumption.assign(data.n(),0);
+        flastp = tsnapshot::knan;
+        flastdefinedp = tsnapshot::knan;
+    }
+
+    virtual void settle(unsigned, const tsnapshot& s) override
+    {
+        if(!isnan(s.p()))
+            flastp = s.p();
+    }
+
+    virtual void consumption(unsigned i, tprice c, tabstime) override
+    {
+        fconsumption[i] += c;
+    }
+
+    virtual void end(const tmarketdata& data) override
+    {
+        if(data.b()==klundefprice || data.a()==khundefprice)
+            flastdefinedp = flastp;
+        else
+            flastdefinedp = (data.b() + data.a()) / 2.0;
+    }
+
+    virtual bool savestate(std::ostream& o) const override
+    {
+        savebinary(o,fconsumption);
+        savebinary(o,flastp);
+        return true;
+    }
+
+    virtual void restorestate(std::istream& i) override
+    {
+        loadbinary(i,fconsumption);
+        loadbinary(i,flastp);
+    }
+
+    /// total consumption of strategy \p i
+    tprice consumption(unsigned i) const { return fconsumption[i]; }
+
+    /// last defined price at the end of the run (\c nan if there was none)
+    double lastdefinedp() const { return flastdefinedp; }
+
+private:
+    std::vector<double> fconsumption;
+    double flastp = tsnapshot::knan;
+    double flastdefinedp = tsnapshot::knan;
+};
+
+/// marketsim::tmetriccollector of the tables of the protocol of a run (see
+/// marketsim::tmarketdata::protocol): the run is divided into \p nsnaps intervals of the same
+/// length; the state of the order book is recorded at their ends, the time of undefined
+/// bid and ask, the traded volume and the consumptions, purchases, selling, demands and
+/// supplies of the strategies are summed over them (an event at time \c t belongs to
+/// the interval containing \c t, the intervals being closed from the left).
+class tprotocolcollector : public tmetriccollector
+{
+public:
+    /// constructor, \p nsnaps is the number of the intervals
+    tprotocolcollector(unsigned nsnaps = 10) : fnsnaps(std::max(1u,nsnaps)) {}
+
+    virtual void start(const tmarketdata& data, tabstime maxtime) override
+    {
+        auto n = data.n();
+        fnames.clear();
+        for(unsigned i=0; i<n; i++)
+            fnames.push_back(data.fstrategyinfos[i].name());
+        fdt = maxtime / fnsnaps;
+        fsnapshots.assign(fnsnaps,tsnapshot(0));
+        fnext = 1;
+        fstate = tsnapshot(0);
+        flast = 0;
+        fsettled = false;
+        fbundef.assign(fnsnaps,0);
+        faundef.assign(fnsnaps,0);
+        fq.assign(fnsnaps,0);
+        for(auto t: { &fconsumption, &fpurchases, &fselling, &fdemand, &fsupply })
+            t->assign(n,std::vector<double>(fnsnaps,0));
+    }
+
+    virtual void settle(unsigned, const tsnapshot& s) override
+    {
+        advance(s.t);
+        fstate = s;
+        fsettled = true;
+        fq[interval(s.t)] += s.q;
+    }
+
+    virtual void trade(unsigned i, tprice, tvolume stockdelta, tabstime t, unsigned) override
+    {
+        if(stockdelta > 0)
+            fpurchases[i][interval(t)] += stockdelta;
+        else
+            fselling[i][interval(t)] -= stockdelta;
+    }
+
+    virtual void consumption(unsigned i, tprice c, tabstime t) override
+    {
+        fconsumption[i][interval(t)] += c;
+    }
+
+    virtual void ds(unsigned i, tprice demand, tvolume supply, tabstime t) override
+    {
+        fdemand[i][interval(t)] += demand;
+        fsupply[i][interval(t)] += supply;
+    }
+
+    virtual void end(const tmarketdata& data) override
+    {
+        advance(fdt * fnsnaps);
+        for(; fnext <= fnsnaps; fnext++)
+            fsnapshots[fnext-1] = fstate;
+        fwallets.clear();
+        fevents.clear();
+        fcomptimes.clear();
+        for(const auto& si: data.fstrategyinfos)
+        {
+            fwallets.push_back(si.wallet());
+            fevents.push_back(si.comptimes().num);
+            fcomptimes.push_back(si.comptimes().average());
+        }
+    }
+
+    virtual bool savestate(std::ostream& o) const override
+    {
+        savebinary(o,fdt);
+        savebinary(o,fsnapshots);
+        savebinary(o,fnext);
+        savebinary(o,fstate);
+        savebinary(o,flast);
+        savebinary(o,fsettled);
+        savebinary(o,fbundef);
+        savebinary(o,faundef);
+        savebinary(o,fq);
+        for(auto t: { &fconsumption, &fpurchases, &fselling, &fdemand, &fsupply })
+        {
+            savebinary(o,static_cast<unsigned>(t->size()));
+            for(const auto& r: *t)
+                savebinary(o,r);
+        }
+        return true;
+    }
+
+    virtual void restorestate(std::istream& i) override
+    {
+        loadbinary(i,fdt);
+        loadbinary(i,fsnapshots);
+        loadbinary(i,fnext);
+        fstate = loadobject<tsnapshot>(i);
+        loadbinary(i,flast);
+        loadbinary(i,fsettled);
+        loadbinary(i,fbundef);
+        loadbinary(i,faundef);
+        loadbinary(i,fq);
+        for(auto t: { &fconsumption, &fpurchases, &fselling, &fdemand, &fsupply })
+        {
+            unsigned n = loadlength<unsigned>(i,1);
+            t->resize(n);
+            for(auto& r: *t)
+                loadbinary(i,r);
+        }
+    }
+
+    /// outputs the protocol (in the format of marketsim::tmarketdata::protocol) to \p o,
+    /// without the tables if no settlement has been recorded
+    void output(std::ostream& o) const
+    {
+        auto n = fnames.size();
+        o << std::endl << "Protocol of a market simulation"
+          << std::endl << std::endl;
+        o << "strategies:";
+        for(unsigned i=0; i<n; i++)
+            o << "," << fnames[i];
+        o << std::endl;
+        o << "c:";
+        for(unsigned i=0; i<n; i++)
+        {
+            double c = 0;
+            for(auto x: fconsumption[i])
+                c += x;
+            o << "," << c;
+        }
+        o << std::endl;
+        o << "m:";
+        for(unsigned i=0; i<fwallets.size(); i++)
+            o << "," << fwallets[i].money();
+        o << std::endl;
+        o << "n:";
+        for(unsigned i=0; i<fwallets.size(); i++)
+            o << "," << fwallets[i].stocks();
+        o << std::endl;
+        o << "# events:";
+        for(auto e: fevents)
+            o << "," << e;
+        o << std::endl;
+        o << "ave comp time:";
+        for(auto t: fcomptimes)
+            o << "," << t;
+        o << std::endl;
+        o << std::endl;
+
+        o << "time snapshots:";
+        if(!fsettled)
+        {
+            o << ",no records in market history" << std::endl;
+            return;
+        }
+        for(unsigned i=1; i<=fnsnaps; i++)
+            o << "," << i * fdt;
+        o << std::endl;
+        o << "b:";
+        for(const auto& s: fsnapshots)
+            o << "," << p2str(s.b);
+        o << std::endl;
+        o << "% undef:";
+        for(auto u: fbundef)
+            o << "," << 100 * u / fdt;
+        o << std::endl;
+        o << "B volume:";
+        for(const auto& s: fsnapshots)
+            o << "," << s.Bvol;
+        o << std::endl;
+        o << "a:";
+        for(const auto& s: fsnapshots)
+            o << "," << p2str(s.a);
+        o << std::endl;
+        o << "% undef:";
+        for(auto u: faundef)
+            o << "," << 100 * u / fdt;
+        o << std::endl;
+        o << "A volume:";
+        for(const auto& s: fsnapshots)
+            o << "," << s.Avol;
+        o << std::endl;
+        o << "q:";
+        for(auto q: fq)
+            o << "," << q;
+        o << std::endl;
+        o << std::endl;
+
+        outputtable(o,"Consumption",fconsumption);
+        outputtable(o,"Purchases",fpurchases);
+        outputtable(o,"Selling",fselling);
+        outputtable(o,"Demand",fdemand);
+        outputtable(o,"Supply",fsupply);
+    }
+
+    /// bid and ask and volumes of the order book at the ends of the intervals
+    const std::vector<tsnapshot>& snapshots() const { return fsnapshots; }
+    /// time of the undefined bid within the intervals
+    const std::vector<tabstime>& bidundefined() const { return fbundef; }
+    /// time of the undefined ask within the intervals
+    const std::vector<tabstime>& askundefined() const { return faundef; }
+    /// traded volume within the intervals
+    const std::vector<double>& volumes() const { return fq; }
+    /// consumptions of the strategies within the intervals
+    const std::vector<std::vector<double>>& consumptions() const { return fconsumption; }
+    /// purchased stocks of the strategies within the intervals
+    const std::vector<std::vector<double>>& purchases() const { return fpurchases; }
+    /// sold stocks of the strategies within the intervals
+    const std::vector<std::vector<double>>& sellings() const { return fselling; }
+    /// demands passed to the strategies within the intervals
+    const std::vector<std::vector<double>>& demands() const { return fdemand; }
+    /// supplies passed to the strategies within the intervals
+    const std::vector<std::vector<double>>& supplies() const { return fsupply; }
+
+private:
+    unsigned interval(tabstime t) const
+    {
+        if(!(fdt > 0) || t <= 0)
+            return 0;
+        return std::min(fnsnaps - 1, static_cast<unsigned>(t / fdt));
+    }
+
+    /// records the snapshots due before \p t and the undefined times until \p t
+    void advance(tabstime t)
+    {
+        for(; fnext <= fnsnaps && fnext * fdt < t; fnext++)
+            fsnapshots[fnext-1] = fstate;
+        bool bundef = fstate.b == klundefprice;
+        bool aundef = fstate.a == khundefprice;
+        while(flast < t && (bundef || aundef))
+        {
+            unsigned j = interval(flast);
+            tabstime h = j + 1 < fnsnaps ? std::min(t, (j + 1) * fdt) : t;
+            if(h <= flast)
+                break;
+            if(bundef)
+                fbundef[j] += h - flast;
+            if(aundef)
+                faundef[j] += h - flast;
+            flast = h;
+        }
+        flast = std::max(flast,t);
+    }
+
+    void outputtable(std::ostream& o, const std::string& title,
+                     const std::vector<std::vector<double>>& table) const
+    {
+        o << title << std::endl;
+        for(unsigned i=0; i<table.size(); i++)
+        {
+            o << fnames[i];
+            for(auto x: table[i])
+                o << "," << x;
+            o << std::endl;
+        }
+        o << std::endl;
+    }
+
+    unsigned fnsnaps;
+    std::vector<std::string> fnames;
+    tabstime fdt = 0;
+    std::vector<tsnapshot> fsnapshots;
+    unsigned fnext = 1;
+    tsnapshot fstate = tsnapshot(0);
+    tabstime flast = 0;
+    /// \c true if a settlement has been recorded
+    bool fsettled = false;
+    std::vector<tabstime> fbundef;
+    std::vector<tabstime> faundef;
+    std::vector<double> fq;
+    std::vector<std::vector<double>> fconsumption;
+    std::vector<std::vector<double>> fpurchases;
+    std::vector<std::vector<double>> fselling;
+    std::vector<std::vector<double>> fdemand;
+    std::vector<std::vector<double>> fsupply;
+    std::vector<twallet> fwallets;
+    std::vector<unsigned> fevents;
+    std::vector<double> fcomptimes;
+};
+
+inline void tmarketdata::protocol(std::ostream& o, tabstime T, unsigned nsnaps) const
+{
+    // the events are replayed (only the order of the settlements matters)
+    tprotocolcollector c(nsnaps);
+    c.start(*this,T);
+    for(const auto& s: fhistory.x())
+        c.settle(0,s);
+    for(unsigned i=0; i<fstrategyinfos.size(); i++)
+    {
+        const auto& si = fstrategyinfos[i];
+        for(const auto& e: si.tradinghistory().x())
+            c.trade(i,e.moneydelta,e.stockdelta,e.t,e.partner);
+        for(const auto& e: si.consumption().x())
+            c.consumption(i,e.famount,e.t);
+        for(const auto& e: si.dshistory().x())
+            c.ds(i,e.demand,e.supply,e.t);
+    }
+    c.end(*this);
+    c.output(o);
+}
+
+} // namespace
+
+#endif // COLLECTORS_HPP
@@ -2,8 +2,13 @@
 #define COMPETITION_HPP
 
 #include "marketsim.hpp"
+#include "marketsim/process.hpp"
+#include "marketsim/resultcache.hpp"
+#include "marketsim/resultsink.hpp"
+#include "marketsim/collectors.hpp"
 #include <iostream>
 #include <fstream>
+#include <memory>
 
 namespace marketsim
 {
@@ -21,29 +26,513 @@ struct tcompetitiondef
     std::string id = "";
     /// market parameters
     tmarketdef marketdef = tmarketdef();
+    /// number of runs evaluated concurrently (0 means the number of cores), in RT competitions
+    /// and with marketsim::tcomptimeclock::process only if \c isolated is set; the outputs and the results are the same as if the runs
+    /// were evaluated one by one
+    unsigned threads = 1;
+    /// if \c true, every run is evaluated in a forked process, so that neither a crash nor
+    /// strategies failing to release control affect the other runs (RT runs then cannot
+    /// use chronos::worker_runtime::fibers nor an executor)
+    bool isolated = false;
+    /// limits of the processes evaluating the runs if \c isolated is set
+    tprocesslimits runlimits;
+    /// if \c true, the competition stops as soon as (after at least \c minsamplesize runs)
+    /// the confidence intervals of the differences of mean consumptions of all the pairs
+    /// of competitors either do not contain zero (the ranking is clear) or are narrower
+    /// than \c targethalfwidth; \c samplesize is then the budget of the runs
+    bool sequential = false;
+    /// sequential mode only: minimal number of runs
+    unsigned minsamplesize = 10;
+    /// sequential mode only: confidence level of the intervals
+    double confidence = 0.95;
+    /// sequential mode only: sufficient half width of the intervals (0 means that only
+    /// the ranking matters)
+    double targethalfwidth = 0;
+    /// if not empty, the directory of the cache of the runs: a run whose competitors
+    /// (their names and keys, see marketsim::competitorbase::key), endowments, parameters,
+    /// seed and \c cachetag were evaluated before is not simulated again
+    /// (see marketsim::tresultcache)
+    std::string cachedir = "";
+    /// identification of what else determines the runs (e.g. the type of the demand and
+    /// supply or the versions of the strategies), used only to key the cached runs
+    std::string cachetag = "";
+    /// format of the results of individual runs written by marketsim::competitiongrid
+    tresultformat resultformat = tresultformat::csv;
 };
 
 /// result of a single strategy within the competition
 struct competitionresult
 {
-    /// total (raw) consumption achieved
-    statcounter consumption;
-    /// total (raw) consumption achieved
-    statcounter value;
+    /// total (raw) consumption achieved (including its quantiles)
+    distributioncounter consumption;
+    /// consumption plus the change of the value of the wallet (at the last defined price)
+    distributioncounter value;
     /// number of runs
     unsigned nruns = 0;
     /// number of runs ended by exception
     unsigned nexcepts = 0;
     /// number of runs in which the strategy failed to release control
     unsigned noverruns = 0;
+    /// differences of the consumption and consumptions of the other strategies within
+    /// the same runs (indexed by the other strategies)
+    std::vector<statcounter> consumptiondifferences;
+
+    /// adds the results \p r of other runs of the same strategy in the same competition
+    void merge(const competitionresult& r)
+    {
+        consumption.merge(r.consumption);
+        value.merge(r.value);
+        nruns += r.nruns;
+        nexcepts += r.nexcepts;
+        noverruns += r.noverruns;
+        consumptiondifferences.resize(std::max(consumptiondifferences.size(),
+                                               r.consumptiondifferences.size()));
+        for(unsigned k=0; k<r.consumptiondifferences.size(); k++)
+            consumptiondifferences[k].merge(r.consumptiondifferences[k]);
+    }
+};
+
+/// quantile of the standard normal distribution at \p p
+inline double normalquantile(double p)
+{
+    double l = -40;
+    double h = 40;
+    for(unsigned k=0; k<100; k++)
+    {
+        double m = (l + h) / 2;
+        if(0.5 * erfc(-m / sqrt(2.0)) < p)
+            l = m;
+        else
+            h = m;
+    }
+    return (l + h) / 2;
+}
+
+/// half width of the (asymptotic) confidence interval of the mean of the sample
+/// summarized in \p s at level \p confidence
+inline double confidencehalfwidth(const statcounter& s, double confidence)
+{
+    if(s.num < 2)
+        return std::numeric_limits<double>::infinity();
+    double var = std::max(0.0, s.var()) / (s.num - 1);
+    return normalquantile(0.5 + confidence / 2) * sqrt(var);
+}
+
+
+/// outcome of a single run of marketsim::compete
+struct tcompetitionrun
+{
+    /// line of the progress output
+    std::string progress;
+    /// results of the strategies
+    std::vector<tresultrecord> records;
+    /// \c false if the run does not count
+    bool valid = false;
+    /// consumptions of the strategies
+    std::vector<double> consumption;
+    /// values of the strategies
+    std::vector<double> value;
+    /// the strategies ended by exception
+    std::vector<bool> excepted;
+    /// the strategies which failed to release control
+    std::vector<bool> overrun;
+
+    /// writes the run to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        savebinary(o,progress);
+        savebinary(o,records);
+        savebinary(o,valid);
+        savebinary(o,consumption);
+        savebinary(o,value);
+        savebinary(o,excepted);
+        savebinary(o,overrun);
+    }
+
+    /// reads the run written by marketsim::tcompetitionrun::save from \p i
+    void load(std::istream& i)
+    {
+        loadbinary(i,progress);
+        loadbinary(i,records);
+        loadbinary(i,valid);
+        loadbinary(i,consumption);
+        loadbinary(i,value);
+        loadbinary(i,excepted);
+        loadbinary(i,overrun);
+    }
+};
+
+/// Performs \p i-th run of marketsim::compete with seed \p seed.
+template <bool chronos, bool logging, typename D>
+inline tcompetitionrun competitionrun(std::vector<competitorbase<chronos>*> competitors,
+                                      const std::vector<twallet>& endowments,
+                                      const tcompetitiondef& compdef,
+                                      unsigned i, int seed,
+                                      std::vector<tstrategy*> &garbage)
+{
+    auto n = competitors.size();
+    tcompetitionrun ret;
+    std::ostringstream o;
+
+    o << i << ",";
+
+    tmarket m(compdef.timeofrun,compdef.marketdef);
+    m.seed(seed);
+    // the scores are accumulated during the run
+    tscorecollector scores;
+    m.addcollector(&scores);
+
+    std::ofstream log;
+    if(logging)
+    {
+        std::ostringstream os;
+        os << compdef.id << "log" << i << ".csv";
+        log.open(os.str());
+        m.setlogging(log,m.def().loggingfilter);
+    }
+
+    try
+    {
+        auto res = m.run<chronos,D>(competitors,endowments,garbage);
+        bool overflow = false;
+        for(unsigned i=0; i<res.size(); i++)
+            if(res[i])
+            {
+                overflow = true;
+                break;
+            }
+        if(overflow)
+            o << "1,";
+        else
+            o << "0,";
+
+        auto rest = static_cast<double>(m.results()->fextraduration.average())
+                      / m.def().chronosduration.count();
+        if(rest < 0)
+            o << "0,overflow," << rest*100 << "%,";
+        else
+        {
+            o << "1,OK," << rest*100 << "%,";
+            auto r = m.results();
+            double p = scores.lastdefinedp();
+            for(unsigned j=0; j<n; j++)
+            {
+                auto& tr= r->fstrategyinfos[j];
+                double m = tr.wallet().money() - endowments[j].money();
+                double n = tr.wallet().stocks() - endowments[j].stocks();
+                double c = scores.consumption(j);
+
+                double v = c + m + n*p;
+                o << c << ",";
+                ret.records.push_back({i, j, c, tr.wallet().money(), tr.wallet().stocks(), p});
+                ret.consumption.push_back(c);
+                ret.value.push_back(v);
+                ret.excepted.push_back(tr.isendedbyexception());
+                ret.overrun.push_back(tr.isoverrun());
+            }
+            ret.valid = true;
+        }
+    }
+    catch (std::runtime_error& e)
+    {
+        o << "0,\"error:" << e.what() << "\"," << std::endl;
+    }
+    catch (...)
+    {
+        o << "0,\"Unknown error\"" << std::endl;
+    }
+    o << std::endl;
+    ret.progress = o.str();
+    return ret;
+}
+
+/// run of a competition to be evaluated by marketsim::competitionruns
+template <bool chronos>
+struct tcompetitionjob
+{
+    const std::vector<competitorbase<chronos>*>* competitors;
+    const std::vector<twallet>* endowments;
+    const tcompetitiondef* compdef;
+    /// index of the run
+    unsigned i;
+    /// seed of the run
+    int seed;
 };
 
+/// key of run \p j in marketsim::tresultcache
+template <bool chronos>
+inline std::string competitionrunkey(const tcompetitionjob<chronos>& j)
+{
+    std::ostringstream o;
+    // format of the cached runs
+    savebinary(o,std::string("run3"));
+    savebinary(o,chronos);
+    savebinary(o,j.compdef->cachetag);
+    savebinary(o,static_cast<unsigned>(j.competitors->size()));
+    for(unsigned k=0; k<j.competitors->size(); k++)
+    {
+        auto c = (*j.competitors)[k];
+        savebinary(o,c->name());
+        savebinary(o,c->key());
+        savebinary(o,c->startswithoutwarmup());
+        savebinary(o,(*j.endowments)[k].money());
+        savebinary(o,(*j.endowments)[k].stocks());
+    }
+    savebinary(o,j.compdef->timeofrun);
+    j.compdef->marketdef.savekey(o);
+    savebinary(o,j.i);
+    savebinary(o,j.seed);
+    return o.str();
+}
+
+/// Evaluates runs \p jobs (by marketsim::competitionrun), at most \p threads of them at
+/// once, in separate child processes subject to \p limits if \p isolated is \c true. Runs
+/// whose processes fail are reported as invalid. Strategies which failed to release control
+/// are stored to \p garbage (unless they ran in a child process).
+template <bool chronos, bool logging, typename D>
+inline std::vector<tcompetitionrun> evaluatecompetitionruns(const std::vector<tcompetitionjob<chronos>>& jobs,
+                                                    unsigned threads, bool isolated,
+                                                    const tprocesslimits& limits,
+                                                    std::vector<tstrategy*> &garbage)
+{
+    std::vector<tcompetitionrun> runs(jobs.size());
+    if(isolated)
+    {
+        // a forked child inherits the pools without their threads
+        if constexpr(chronos)
+            for(const auto& j: jobs)
+                if(j.compdef->marketdef.workerruntime == ::chronos::worker_runtime::fibers
+                        || j.compdef->marketdef.executor)
+                    throw std::runtime_error("Isolated runs cannot use fibers or an executor");
+        std::vector<std::unique_ptr<tchildprocess>> children(jobs.size());
+        unsigned started = 0;
+        for(unsigned k=0; k<jobs.size(); k++)
+        {
+            for(; started < jobs.size() && started < k + threads; started++)
+            {
+                const tcompetitionjob<chronos>& j = jobs[started];
+                children[started].reset(new tchildprocess([&j](std::ostream& o)
+                {
+                    // strategies which failed to release control are released with the process
+                    std::vector<tstrategy*> garbage;
+                    competitionrun<chronos,logging,D>(*j.competitors,*j.endowments,*j.compdef,
+                                                      j.i,j.seed,garbage).save(o);
+                }, limits));
+            }
+            std::string output;
+            std::string error = children[k]->finish(output);
+            children[k].reset();
+            if(error == "")
+            {
+                std::istringstream is(output);
+                runs[k].load(is);
+                if(!is)
+                    error = "incomplete output of the run";
+            }
+            if(error != "")
+            {
+                std::ostringstream o;
+                o << jobs[k].i << ",0,\"error:" << error << "\"," << std::endl << std::endl;
+                runs[k] = tcompetitionrun();
+                runs[k].progress = o.str();
+            }
+        }
+    }
+    else if(threads == 1 || jobs.size() == 1)
+    {
+        for(unsigned k=0; k<jobs.size(); k++)
+        {
+            const tcompetitionjob<chronos>& j = jobs[k];
+            runs[k] = competitionrun<chronos,logging,D>(*j.competitors,*j.endowments,*j.compdef,
+                                                        j.i,j.seed,garbage);
+        }
+    }
+    else
+    {
+        tworkstealingpool pool(threads);
+        std::vector<std::vector<tstrategy*>> garbages(jobs.size());
+        std::vector<std::function<void()>> tasks;
+        for(unsigned k=0; k<jobs.size(); k++)
+            tasks.push_back([&,k]()
+            {
+                const tcompetitionjob<chronos>& j = jobs[k];
+                runs[k] = competitionrun<chronos,logging,D>(*j.competitors,*j.endowments,*j.compdef,
+                                                            j.i,j.seed,garbages[k]);
+            });
+        pool.run(tasks);
+        for(auto& g: garbages)
+            garbage.insert(garbage.end(), g.begin(), g.end());
+    }
+    return runs;
+}
+
+/// As marketsim::evaluatecompetitionruns, but the runs found in the caches of their
+/// competitions (see marketsim::tcompetitiondef::cachedir) are not evaluated, and
+/// the valid evaluated runs are stored there.
+template <bool chronos, bool logging, typename D>
+inline std::vector<tcompetitionrun> competitionruns(const std::vector<tcompetitionjob<chronos>>& jobs,
+                                                    unsigned threads, bool isolated,
+                                                    const tprocesslimits& limits,
+                                                    std::vector<tstrategy*> &garbage)
+{
+    std::vector<tcompetitionrun> runs(jobs.size());
+    std::vector<std::string> keys(jobs.size());
+    std::vector<tcompetitionjob<chronos>> missing;
+    std::vector<unsigned> where;
+    for(unsigned k=0; k<jobs.size(); k++)
+    {
+        const std::string& dir = jobs[k].compdef->cachedir;
+        if(dir != "")
+        {
+            keys[k] = competitionrunkey<chronos>(jobs[k]);
+            std::string value;
+            if(tresultcache(dir).load(keys[k],value))
+            {
+                std::istringstream is(value);
+                runs[k].load(is);
+                if(is)
+                    continue;
+            }
+        }
+        missing.push_back(jobs[k]);
+        where.push_back(k);
+    }
+    auto evaluated = evaluatecompetitionruns<chronos,logging,D>(missing,threads,isolated,
+                                                                limits,garbage);
+    for(unsigned k=0; k<evaluated.size(); k++)
+    {
+        unsigned w = where[k];
+        runs[w] = evaluated[k];
+        if(keys[w] != "" && runs[w].valid)
+        {
+            std::ostringstream os;
+            runs[w].save(os);
+            tresultcache(jobs[w].compdef->cachedir).store(keys[w],os.str());
+        }
+    }
+    return runs;
+}
+
+/// number of runs evaluated at once by a competition defined by \p compdef
+/// (see marketsim::tcompetitiondef::threads)
+template <bool chronos>
+inline unsigned competitionthreads(const tcompetitiondef& compdef)
+{
+    if(chronos && !compdef.isolated)
+        return 1;
+    // the process clock would charge every run also the times of the concurrent ones
+    if(compdef.marketdef.comptimeclock == tcomptimeclock::process && !compdef.isolated)
+        return 1;
+    if(compdef.threads == 0)
+        return std::max(1u, std::thread::hardware_concurrency());
+    return compdef.threads;
+}
+
+/// Collects the runs of a competition (in the order of the runs) into
+/// marketsim::competitionresult's and decides when the competition ends.
+class tcompetitionaccumulator
+{
+public:
+    /// constructor, \p n is the number of competitors, the parameters of the competition
+    /// are \p compdef, the results of individual runs are output to \p sink and
+    /// the running results to \p o
+    tcompetitionaccumulator(unsigned n, const tcompetitiondef& compdef,
+                            tresultsink& sink, std::ostream& o)
+        : fress(n), fcompdef(compdef), fsink(sink), fo(o)
+    {
+        for(auto& r: fress)
+            r.consumptiondifferences.resize(n);
+    }
+
+    /// adds run \p r (the next one) to the totals
+    void merge(const tcompetitionrun& r)
+    {
+        auto n = fress.size();
+        fnext++;
+        fo << r.progress;
+        for(const auto& rec: r.records)
+            fsink.add(rec);
+        if(!r.valid)
+            return;
+        for(unsigned j=0; j<n; j++)
+        {
+            fress[j].consumption.add(r.consumption[j]);
+            if(!isnan(r.value[j]))
+                fress[j].value.add(r.value[j]);
+            fress[j].nruns++;
+            if(r.excepted[j])
+                fress[j].nexcepts++;
+            if(r.overrun[j])
+                fress[j].noverruns++;
+            for(unsigned k=0; k<n; k++)
+                if(k != j)
+                    fress[j].consumptiondifferences[k].add(r.consumption[j]-r.consumption[k]);
+        }
+        fnobs++;
+    }
+
+    /// \c true if the sequential mode may stop (see marketsim::tcompetitiondef::sequential)
+    bool resolved() const
+    {
+        if(!fcompdef.sequential || fnobs < std::max(2u,fcompdef.minsamplesize))
+            return false;
+        for(unsigned j=0; j<fress.size(); j++)
+            for(unsigned k=j+1; k<fress.size(); k++)
+            {
+                auto& d = fress[j].consumptiondifferences[k];
+                double h = confidencehalfwidth(d, fcompdef.confidence);
+                if(fabs(d.average()) <= h && h > fcompdef.targethalfwidth)
+                    return false;
+            }
+        return true;
+    }
+
+    /// \c true if no more runs are needed
+    bool finished() const
+    {
+        return fnobs >= fcompdef.samplesize || fnext >= fcompdef.samplesize * 2 || resolved();
+    }
+
+    /// the runs to be evaluated next by \p threads threads (their outcomes are to be
+    /// merged in their order until marketsim::tcompetitionaccumulator::finished)
+    std::vector<unsigned> nextruns(unsigned threads) const
+    {
+        std::vector<unsigned> ret;
+        if(finished())
+            return ret;
+        unsigned m = threads == 1 ? 1
+                       : std::min(fcompdef.samplesize - fnobs, fcompdef.samplesize * 2 - fnext);
+        // in the sequential mode, the runs are added in batches to be able to stop early
+        if(fcompdef.sequential)
+            m = std::min(m, std::max(threads, fcompdef.minsamplesize > fnobs
+                                              ? fcompdef.minsamplesize - fnobs : 0));
+        for(unsigned k=0; k<m; k++)
+            ret.push_back(fnext + k);
+        return ret;
+    }
 
+    /// seed of run \p i
+    int seed(unsigned i) const { return fcompdef.seed + static_cast<int>(i) * fcompdef.seeddelta; }
+
+    /// results of the competition
+    const std::vector<competitionresult>& results() const { return fress; }
+
+    /// number of valid runs
+    unsigned nobs() const { return fnobs; }
+
+private:
+    std::vector<competitionresult> fress;
+    const tcompetitiondef& fcompdef;
+    tresultsink& fsink;
+    std::ostream& fo;
+    unsigned fnobs = 0;
+    unsigned fnext = 0;
+};
 
 /// Evaluates the current repeatedly running strategies corresponding to
 /// \p competitors. The parameters of the competition oar in
 /// \p compdef (note that calibration of marketsim::tmarketdef is not done within procedure),
-/// results of individual runs are output to \p rescsv.
+/// results of individual runs are output to \p sink.
 /// \p garbage is necessary to provide to store strategies which failed
 /// to release control (which can happen only if \c chronos==true).
 /// The running results are printed to \p o.
@@ -57,7 +546,7 @@ inline std::vector<competitionresult>
         compete(std::vector<competitorbase<chronos>*> competitors,
                 std::vector<twallet> endowments,
                     const tcompetitiondef& compdef,
-                    std::ostream& rescsv,
+                    tresultsink& sink,
                     std::vector<tstrategy*> &garbage,
                     std::ostream& o = std::clog
                     )
@@ -67,99 +556,338 @@ inline std::vector<competitionresult>
     if constexpr(chronos && calibrate)
             def.calibrate(n,o);
 
-    std::vector<competitionresult> ress(n);
-
     o << "turn, runresult, valid,result,tickperc";
     for(unsigned j=0; j<n; j++)
        o << "," << competitors[j]->name() ;
     o << std::endl;
 
-    int seed = compdef.seed;
-
-    rescsv << "turn,id,c,m,s,lastp" << std::endl;
+    std::vector<std::string> names;
+    for(unsigned j=0; j<n; j++)
+        names.push_back(competitors[j]->name());
+    sink.begin(names);
 
-    unsigned nobs = 0;
-    for(unsigned i=0; nobs<compdef.samplesize && i<compdef.samplesize * 2; i++)
+    tcompetitionaccumulator acc(n,compdef,sink,o);
+    unsigned threads = competitionthreads<chronos>(compdef);
+    // the runs evaluated at once are merged in their order
+    for(auto is = acc.nextruns(threads); is.size(); is = acc.nextruns(threads))
     {
-        o << i << ",";
+        std::vector<tcompetitionjob<chronos>> jobs;
+        for(auto i: is)
+            jobs.push_back({&competitors, &endowments, &compdef, i, acc.seed(i)});
+        auto runs = competitionruns<chronos,logging,D>(jobs,threads,compdef.isolated,
+                                                       compdef.runlimits,garbage);
+        for(unsigned k=0; k<runs.size() && !acc.finished(); k++)
+            acc.merge(runs[k]);
+    }
+    sink.end();
+    if(acc.nobs() < compdef.samplesize && acc.resolved())
+        o << "confidence reached after " << acc.nobs() << " runs" << std::endl;
+    return acc.results();
+}
 
-        tmarket m(compdef.timeofrun,compdef.marketdef);
-        m.seed(seed);
-        seed += compdef.seeddelta;
+/// marketsim::compete writing the results of individual runs to \p rescsv
+/// by marketsim::tcsvresultsink
+template <bool chronos=true, bool calibrate=true, bool logging = false, typename D=tnodemandsupply>
+inline std::vector<competitionresult>
+        compete(std::vector<competitorbase<chronos>*> competitors,
+                std::vector<twallet> endowments,
+                    const tcompetitiondef& compdef,
+                    std::ostream& rescsv,
+                    std::vector<tstrategy*> &garbage,
+                    std::ostream& o = std::clog
+                    )
+{
+    tcsvresultsink sink(rescsv);
+    return compete<chronos,calibrate,logging,D>(competitors,endowments,compdef,sink,garbage,o);
+}
 
-        std::ofstream log;
-        if(logging)
+/// Merges the records of the runs of a competition read by \p reader (a
+/// marketsim::tcsvresultreader or a marketsim::tbinaryresultreader) into the results of
+/// its strategies having endowments \p endowments; the records of a run have to be
+/// adjacent. The numbers of exceptions and overruns are not recorded, so they stay zero.
+/// \throw std::runtime_error if a run lacks some records
+template <typename R>
+inline std::vector<competitionresult> mergeresultrecords(R& reader,
+                                                         const std::vector<twallet>& endowments)
+{
+    auto n = endowments.size();
+    std::vector<competitionresult> ress(n);
+    for(auto& r: ress)
+        r.consumptiondifferences.resize(n);
+    std::vector<tresultrecord> run;
+    // adds the run as marketsim::tcompetitionaccumulator::merge does
+    auto add = [&]()
+    {
+        if(run.size() != n)
+            throw std::runtime_error("Incomplete run in marketsim result file");
+        std::vector<double> cs(n);
+        for(const auto& rec: run)
         {
-            std::ostringstream os;
-            os << compdef.id << "log" << i << ".csv";
-            log.open(os.str());
-            m.setlogging(log,m.def().loggingfilter);
+            auto j = rec.strategy;
+            double m = rec.m - endowments[j].money();
+            double s = rec.s - endowments[j].stocks();
+            double v = rec.c + m + s*rec.lastp;
+            cs[j] = rec.c;
+            ress[j].consumption.add(rec.c);
+            if(!isnan(v))
+                ress[j].value.add(v);
+            ress[j].nruns++;
         }
+        for(unsigned j=0; j<n; j++)
+            for(unsigned k=0; k<n; k++)
+                if(k != j)
+                    ress[j].consumptiondifferences[k].add(cs[j]-cs[k]);
+        run.clear();
+    };
+    tresultrecord rec;
+    while(reader.next(rec))
+    {
+        if(run.size() && rec.turn != run[0].turn)
+            add();
+        run.push_back(rec);
+    }
+    if(run.size())
+        add();
+    return ress;
+}
+
+/// Reads shard \p name in format \p format, written by a competition of strategies
+/// named \p names having endowments \p endowments, see marketsim::mergeresultrecords.
+inline std::vector<competitionresult> loadresultshard(const std::string& name,
+                                                      tresultformat format,
+                                                      const std::vector<std::string>& names,
+                                                      const std::vector<twallet>& endowments)
+{
+    bool binary = format == tresultformat::binary;
+    std::ifstream i(name, binary ? std::ios::in | std::ios::binary : std::ios::in);
+    if(!i)
+        throw std::runtime_error("Cannot open " + name);
+    if(binary)
+    {
+        tbinaryresultreader r(i);
+        if(r.names() != names)
+            throw std::runtime_error(name + " has other strategies");
+        return mergeresultrecords(r,endowments);
+    }
+    else
+    {
+        tcsvresultreader r(i,names);
+        return mergeresultrecords(r,endowments);
+    }
+}
+
+/// Cell of a grid of competitions evaluated by marketsim::competitiongrid, i.e. the
+/// arguments of a single competition. The results of its runs are written to shard
+/// <tt>def.id + "competition.csv"</tt> (<tt>def.id + "competition.msr"</tt> if
+/// marketsim::tcompetitiondef::resultformat is marketsim::tresultformat::binary).
+template <bool chronos>
+struct tcompetitioncell
+{
+    /// constructor, \p adef are the parameters of the competition
+    tcompetitioncell(const tcompetitiondef& adef) : def(adef) {}
+
+    std::vector<competitorbase<chronos>*> competitors;
+    std::vector<twallet> endowments;
+    tcompetitiondef def;
+    /// competitors created by (and living with) the cell
+    std::vector<std::shared_ptr<competitorbase<chronos>>> owned;
+
+    /// name of the shard of the results of the runs
+    std::string shard() const
+    {
+        return def.id + (def.resultformat == tresultformat::binary ? "competition.msr"
+                                                                    : "competition.csv");
+    }
+
+    /// adds competitor \p c with endowment \p e
+    void add(competitorbase<chronos>* c, const twallet& e)
+    {
+        competitors.push_back(c);
+        endowments.push_back(e);
+    }
+
+    /// adds competitors \p cs, each with endowment \p e
+    void add(const std::vector<competitorbase<chronos>*>& cs, const twallet& e)
+    {
+        for(auto c: cs)
+            add(c,e);
+    }
+
+    /// adds a competitor owned by the cell, i.e. marketsim::competitor<S,chronos,nowarmup>
+    /// named \p name, with endowment \p e
+    template <typename S, bool nowarmup = false>
+    void add(const std::string& name, const twallet& e)
+    {
+        owned.push_back(std::make_shared<competitor<S,chronos,nowarmup>>(name));
+        add(owned.back().get(),e);
+    }
+};
+
+/// Evaluates competitions \p cells (see marketsim::compete): their runs are expanded into
+/// jobs evaluated together, as set by marketsim::tcompetitiondef::threads,
+/// marketsim::tcompetitiondef::isolated and marketsim::tcompetitiondef::runlimits of the
+/// first cell. The results of individual runs of every cell are written to its own shard
+/// (see marketsim::tcompetitioncell), the running results to \c std::clog (of more cells,
+/// as soon as their runs are merged, each line prefixed by the id of the cell), and the
+/// summaries to \p protocol. The summaries of the cells with binary shards are merged from
+/// the shards (see marketsim::loadresultshard), the other ones are kept in memory, as the
+/// CSV shards are rounded.
+/// If \p finished is given, it is called with the index and the results of every cell
+/// as soon as the cell is finished.
+/// \return results of the cells
+template <bool chronos=true, bool calibrate = true, bool logging = false,
+          typename D = tnodemandsupply>
+inline std::vector<std::vector<competitionresult>>
+        competitiongrid(const std::vector<tcompetitioncell<chronos>>& cells,
+                        std::ostream& protocol,
+                        std::function<void(unsigned, const std::vector<competitionresult>&)>
+                             finished = nullptr)
+{
+    std::vector<tstrategy*> garbage;
+    std::vector<std::unique_ptr<std::ofstream>> shards;
+    std::vector<std::unique_ptr<tresultsink>> sinks;
+    std::vector<std::unique_ptr<std::ostringstream>> progresses;
+    std::vector<std::unique_ptr<tcompetitionaccumulator>> accs;
+    for(auto& c: cells)
+    {
+        bool binary = c.def.resultformat == tresultformat::binary;
+        std::string name = c.shard();
+        shards.emplace_back(binary ? new std::ofstream(name, std::ios::binary)
+                                   : new std::ofstream(name));
+        if(!*shards.back())
+            throw std::runtime_error("Cannot open " + name);
+        if(binary)
+            sinks.emplace_back(new tbinaryresultsink(*shards.back()));
+        else
+            sinks.emplace_back(new tcsvresultsink(*shards.back()));
+        progresses.emplace_back(new std::ostringstream);
+        std::ostream& o = cells.size() == 1 ? std::clog : *progresses.back();
+
+        auto n = c.competitors.size();
+        tmarketdef def = c.def.marketdef;
+        if constexpr(chronos && calibrate)
+                def.calibrate(n,o);
+
+        o << "turn, runresult, valid,result,tickperc";
+        for(unsigned j=0; j<n; j++)
+           o << "," << c.competitors[j]->name() ;
+        o << std::endl;
+        std::vector<std::string> names;
+        for(unsigned j=0; j<n; j++)
+            names.push_back(c.competitors[j]->name());
+        sinks.back()->begin(names);
 
-        try
+        accs.emplace_back(new tcompetitionaccumulator(n,c.def,*sinks.back(),o));
+    }
+
+    // passes the running results of the cells gathered so far to std::clog
+    auto flushprogress = [&]()
+    {
+        if(cells.size() == 1)
+            return;
+        for(unsigned c=0; c<cells.size(); c++)
         {
-            auto res = m.run<chronos,D>(competitors,endowments,garbage);
-            bool overflow = false;
-            for(unsigned i=0; i<res.size(); i++)
-                if(res[i])
-                {
-                    overflow = true;
-                    break;
-                }
-            if(overflow)
-                o << "1,";
-            else
-                o << "0,";
-
-            auto rest = static_cast<double>(m.results()->fextraduration.average())
-                          / m.def().chronosduration.count();
-            if(rest < 0)
-                o << "0,overflow," << rest*100 << "%,";
-            else
+            std::istringstream is(progresses[c]->str());
+            progresses[c]->str("");
+            std::string prefix = cells[c].def.id.size() ? cells[c].def.id : std::to_string(c);
+            for(std::string l; std::getline(is,l); )
+                std::clog << prefix << "," << l << std::endl;
+        }
+    };
+    flushprogress();
+
+    std::vector<bool> reported(cells.size(),false);
+    auto report = [&]()
+    {
+        for(unsigned c=0; c<cells.size(); c++)
+            if(!reported[c] && accs[c]->finished())
             {
-                o << "1,OK," << rest*100 << "%,";
-                auto r = m.results();
-                double p = r->lastdefinedp();
-                for(unsigned j=0; j<n; j++)
+                reported[c] = true;
+                if(finished)
+                    finished(c,accs[c]->results());
+            }
+    };
+
+    if(cells.size())
+    {
+        const tcompetitiondef& gd = cells[0].def;
+        unsigned threads = competitionthreads<chronos>(gd);
+        for(;;)
+        {
+            std::vector<tcompetitionjob<chronos>> jobs;
+            std::vector<unsigned> owners;
+            for(unsigned c=0; c<cells.size(); c++)
+                for(auto i: accs[c]->nextruns(threads))
                 {
-                    auto& tr= r->fstrategyinfos[j];
-                    double m = tr.wallet().money() - endowments[j].money();
-                    double n = tr.wallet().stocks() - endowments[j].stocks();
-                    double c = tr.totalconsumption();
-
-                    double v = c + m + n*p;
-                    o << c << ",";
-                    rescsv << i << "," << competitors[j]->name() << j << ","
-                           << c << "," << tr.wallet().money() << ","
-                           << tr.wallet().stocks() << ",";
-                    if(!isnan(p))
-                        rescsv << p;
-                    rescsv << std::endl;
-                    ress[j].consumption.add(c);
-                    if(!isnan(v))
-                        ress[j].value.add(v);
-                    ress[j].nruns++;
-                    if(tr.isendedbyexception())
-                        ress[j].nexcepts++;
-                    if(tr.isoverrun())
-                        ress[j].noverruns++;
+                    jobs.push_back({&cells[c].competitors, &cells[c].endowments,
+                                    &cells[c].def, i, accs[c]->seed(i)});
+                    owners.push_back(c);
                 }
-                nobs++;
-            }
+            if(jobs.empty())
+                break;
+            auto runs = competitionruns<chronos,logging,D>(jobs,threads,gd.isolated,
+                                                           gd.runlimits,garbage);
+            // in the order of the runs within every cell
+            for(unsigned k=0; k<runs.size(); k++)
+                if(!accs[owners[k]]->finished())
+                    accs[owners[k]]->merge(runs[k]);
+            flushprogress();
+            report();
         }
-        catch (std::runtime_error& e)
+    }
+    report();
+
+    std::vector<std::vector<competitionresult>> ress;
+    for(unsigned c=0; c<cells.size(); c++)
+    {
+        auto& acc = *accs[c];
+        sinks[c]->end();
+        shards[c]->close();
+        std::ostream& o = cells.size() == 1 ? std::clog : *progresses[c];
+        if(acc.nobs() < cells[c].def.samplesize && acc.resolved())
+            o << "confidence reached after " << acc.nobs() << " runs" << std::endl;
+
+        // the CSV shard is rounded to the default precision of the stream, so its
+        // summaries are those of the accumulator
+        auto res = acc.results();
+        if(cells[c].def.resultformat == tresultformat::binary)
         {
-            o << "0,\"error:" << e.what() << "\"," << std::endl;
+            std::vector<std::string> names;
+            for(auto cp: cells[c].competitors)
+                names.push_back(cp->name());
+            res = loadresultshard(cells[c].shard(), cells[c].def.resultformat, names,
+                                  cells[c].endowments);
+            // not recorded in the shards
+            for(unsigned i=0;i<res.size();i++)
+            {
+                res[i].nexcepts = acc.results()[i].nexcepts;
+                res[i].noverruns = acc.results()[i].noverruns;
+            }
         }
-        catch (...)
+        protocol << "Protocol of competition";
+        if(cells.size() > 1)
+            protocol << " " << cells[c].def.id;
+        protocol << "." << std::endl;
+        for(unsigned i=0;i<res.size();i++)
         {
-            o << "0,\"Unknown error\"" << std::endl;
+           const statcounter& s = res[i].consumption;
+           protocol << cells[c].competitors[i]->name() << " " << s.average()
+              << " (" << sqrt(s.var() / s.num ) << ")"
+              << " [" << res[i].nruns << " runs, " << res[i].nexcepts << " exceptions, "
+              << res[i].noverruns << " overruns]"
+              << std::endl;
         }
-        o << std::endl;
+        ress.push_back(res);
     }
+    flushprogress();
+    if(garbage.size())
+        std::clog << garbage.size()
+            << " overrun strategies in garbage, sorry for memory leaks." << std::endl;
     return ress;
 }
 
+/// Evaluates a competition (see marketsim::compete), the results of individual runs
+/// are written to <tt>cd.id + "competition.csv"</tt>, the summary to \p protocol.
 template <bool chronos=true, bool calibrate = true, bool logging = false,
           typename D = tnodemandsupply>
 inline std::vector<competitionresult> competition(std::vector<competitorbase<chronos>*> competitors,
@@ -168,29 +896,10 @@ inline std::vector<competitionresult> competition(std::vector<competitorbase<chr
                                   std::ostream& protocol
                                   )
 {
-   std::vector<tstrategy*> garbage;
-
-   std::ofstream rescsv("competition.csv");
-   if(!rescsv)
-       throw std::runtime_error("Cannot open competition.csv");
-
-   auto res = compete<chronos,calibrate,logging,D>(competitors,endowments,
-                                                 cd,rescsv,garbage,std::clog);
-
-   protocol << "Protocol of competition." << std::endl;
-   for(unsigned i=0;i<res.size();i++)
-   {
-      const statcounter& c = res[i].consumption;
-      protocol << competitors[i]->name() << " " << c.average()
-         << " (" << sqrt(c.var() / c.num ) << ")"
-         << " [" << res[i].nruns << " runs, " << res[i].nexcepts << " exceptions, "
-         << res[i].noverruns << " overruns]"
-         << std::endl;
-   }
-   if(garbage.size())
-        std::clog << garbage.size()
-            << " overrun strategies in garbage, sorry for memory leaks." << std::endl;
-   return res;
+    tcompetitioncell<chronos> cell(cd);
+    cell.competitors = competitors;
+    cell.endowments = endowments;
+    return competitiongrid<chronos,calibrate,logging,D>({cell},protocol)[0];
 }
 
 
@@ -0,0 +1,85 @@
+#ifndef CPUTIME_HPP
+#define CPUTIME_HPP
+
+#include <time.h>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace marketsim
+{
+
+/// returns the CPU time (in seconds) consumed so far by the calling thread
+inline double threadcputime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/// returns the time stamp counter of the processor converted to seconds (the conversion
+/// is calibrated against std::chrono::steady_clock at the first call); where there is no
+/// such counter, std::chrono::steady_clock is used instead
+inline double tsctime()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    static const double secondspertick = []()
+    {
+        auto s0 = std::chrono::steady_clock::now();
+        auto t0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto t1 = __rdtsc();
+        auto s1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(s1-s0).count() / (t1-t0);
+    }();
+    return __rdtsc() * secondspertick;
+#else
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/// clock measuring computation times of the strategies in the event driven simulation
+enum class tcomptimeclock
+{
+    /// \c ::clock(), i.e. CPU time of the whole process (coarse, includes the other threads)
+    process,
+    /// CPU time of the calling thread (\c CLOCK_THREAD_CPUTIME_ID, nanosecond resolution)
+    thread,
+    /// time stamp counter of the processor (cheapest, but wall time, i.e. counts also
+    /// the time the thread was descheduled)
+    tsc
+};
+
+/// Converts measured computation times to the time charged to the strategies: the charged
+/// time is \c offset + \c scale * measured time (\c scale relates the simulating machine to
+/// the modelled one, \c offset models a fixed latency of every event).
+struct tcomptimemodel
+{
+    double scale = 1;
+    double offset = 0;
+
+    /// the time charged for measured time \p measured
+    double charge(double measured) const { return offset + scale * measured; }
+};
+
+/// reads the clock \p c (in seconds)
+inline double clocktime(tcomptimeclock c)
+{
+    switch(c)
+    {
+    case tcomptimeclock::process:
+        return static_cast<double>(::clock()) / CLOCKS_PER_SEC;
+    case tcomptimeclock::tsc:
+        return tsctime();
+    case tcomptimeclock::thread:
+    default:
+        return threadcputime();
+    }
+}
+
+} // namespace
+
+#endif // CPUTIME_HPP
@@ -0,0 +1,150 @@
+#ifndef EVENTQUEUE_HPP
+#define EVENTQUEUE_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace marketsim
+{
+
+/// Scheduler of the event driven simulation: an indexed binary heap of the pending events,
+/// namely an event (call of marketsim::teventdrivenstrategy::event) and a request settlement
+/// of each strategy, and the update of demand and supply. Every event has a single slot which
+/// is rescheduled by marketsim::teventqueue::set in O(log n).
+///
+/// Events are ordered by time; simultaneous ones are ordered deterministically: strategies'
+/// events before the demand/supply update, strategies with higher indices first and
+/// a request settlement before an event of the same strategy.
+class teventqueue
+{
+public:
+    /// constructs a queue of \p nstrategies strategies with all the events at infinity
+    teventqueue(unsigned nstrategies) :
+        fn(nstrategies),
+        ftimes(2*nstrategies+1, std::numeric_limits<double>::max()),
+        fheap(2*nstrategies+1),
+        fpos(2*nstrategies+1)
+    {
+        for(unsigned k=0; k<fheap.size(); k++)
+        {
+            fheap[k] = k;
+            fpos[k] = k;
+        }
+        for(unsigned k=fheap.size() / 2; k-- > 0; )
+            down(k);
+    }
+
+    /// id of the event of strategy \p i
+    static unsigned eventid(unsigned i) { return 2*i; }
+    /// id of the request settlement of strategy \p i
+    static unsigned requestid(unsigned i) { return 2*i+1; }
+    /// id of the demand/supply update
+    unsigned dsid() const { return 2*fn; }
+
+    /// true if \p id is a request settlement
+    bool isrequest(unsigned id) const { return id < dsid() && id % 2 == 1; }
+    /// true if \p id is the demand/supply update
+    bool isds(unsigned id) const { return id == dsid(); }
+    /// strategy of event \p id (not applicable to the demand/supply update)
+    static unsigned strategy(unsigned id) { return id / 2; }
+
+    /// time of event \p id
+    double time(unsigned id) const { return ftimes[id]; }
+
+    /// (re)schedules event \p id to time \p t
+    void set(unsigned id, double t)
+    {
+        double old = ftimes[id];
+        ftimes[id] = t;
+        if(t < old)
+            up(fpos[id]);
+        else
+            down(fpos[id]);
+    }
+
+    /// id of the first event
+    unsigned top() const { return fheap[0]; }
+
+    /// time of the first event but the top one (infinity if there is none)
+    double secondtime() const
+    {
+        double t = std::numeric_limits<double>::max();
+        for(unsigned k=1; k<=2 && k<fheap.size(); k++)
+            t = std::min(t,ftimes[fheap[k]]);
+        return t;
+    }
+
+    /// \c true if event \p a precedes event \p b
+    bool before(unsigned a, unsigned b) const
+    {
+        if(ftimes[a] != ftimes[b])
+            return ftimes[a] < ftimes[b];
+        return rank(a) < rank(b);
+    }
+
+    /// calls \p f(id) for all the events due not later than \p bound (in no particular order)
+    template <typename F>
+    void foreachuntil(double bound, F f) const
+    {
+        visit(0, bound, f);
+    }
+
+private:
+    unsigned rank(unsigned id) const
+    {
+        if(id == dsid())
+            return 2*fn;
+        return 2*(fn-1-strategy(id)) + (isrequest(id) ? 0 : 1);
+    }
+
+    void swap(unsigned k, unsigned l)
+    {
+        std::swap(fheap[k],fheap[l]);
+        fpos[fheap[k]] = k;
+        fpos[fheap[l]] = l;
+    }
+
+    void up(unsigned k)
+    {
+        while(k > 0 && before(fheap[k],fheap[(k-1)/2]))
+        {
+            swap(k,(k-1)/2);
+            k = (k-1)/2;
+        }
+    }
+
+    void down(unsigned k)
+    {
+        for(;;)
+        {
+            unsigned m = k;
+            for(unsigned c=2*k+1; c<=2*k+2 && c<fheap.size(); c++)
+                if(before(fheap[c],fheap[m]))
+                    m = c;
+            if(m == k)
+                return;
+            swap(k,m);
+            k = m;
+        }
+    }
+
+    template <typename F>
+    void visit(unsigned k, double bound, F& f) const
+    {
+        if(k >= fheap.size() || ftimes[fheap[k]] > bound)
+            return;
+        f(fheap[k]);
+        visit(2*k+1,bound,f);
+        visit(2*k+2,bound,f);
+    }
+
+    unsigned fn;
+    std::vector<double> ftimes;
+    std::vector<unsigned> fheap;
+    std::vector<unsigned> fpos;
+};
+
+} // namespace
+
+#endif // EVENTQUEUE_HPP
@@ -0,0 +1,191 @@
+#ifndef PROCESS_HPP
+#define PROCESS_HPP
+
+#include <sstream>
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+#include <stdexcept>
+#include <chrono>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+namespace marketsim
+{
+
+/// resource limits of a marketsim::tchildprocess (zeros mean no limit)
+struct tprocesslimits
+{
+    /// CPU time of the process (in seconds, including all its threads)
+    unsigned cputime = 0;
+    /// address space of the process (in bytes)
+    std::size_t memory = 0;
+    /// wall time of the process (in seconds, from its start), the process is killed when
+    /// it elapses (e.g. if it sleeps or waits, consuming no CPU time)
+    unsigned walltime = 0;
+};
+
+/// Function evaluated in a forked child process, its output is passed to the parent
+/// through a pipe. Whatever the function does (crashes, exceeds the limits, leaves threads
+/// running), the parent is not affected and the resources are released once the child ends.
+class tchildprocess
+{
+public:
+    /// forks a child calling \p f(o), where \p o is the stream passed to the parent;
+    /// the child is subject to limits \p limits
+    template <typename F>
+    tchildprocess(F f, const tprocesslimits& limits)
+    {
+        // otherwise the content of the buffers would be output also by the child
+        std::cout.flush();
+        std::clog.flush();
+        std::cerr.flush();
+        int fd[2];
+        if(pipe(fd) != 0)
+            throw std::runtime_error(std::string("Cannot create pipe: ") + strerror(errno));
+        fstart = std::chrono::steady_clock::now();
+        fwalltime = limits.walltime;
+        fpid = fork();
+        if(fpid < 0)
+        {
+            ::close(fd[0]);
+            ::close(fd[1]);
+            throw std::runtime_error(std::string("Cannot fork: ") + strerror(errno));
+        }
+        if(fpid == 0)
+        {
+            ::close(fd[0]);
+            int status = 0;
+            try
+            {
+                setlimits(limits);
+                std::ostringstream o;
+                f(o);
+                std::string s = o.str();
+                for(std::size_t w = 0; w < s.size(); )
+                {
+                    auto r = ::write(fd[1], s.data() + w, s.size() - w);
+                    if(r <= 0)
+                    {
+                        status = 1;
+                        break;
+                    }
+                    w += r;
+                }
+            }
+            catch(...)
+            {
+                status = 1;
+            }
+            std::cout.flush();
+            std::clog.flush();
+            std::cerr.flush();
+            // threads of the function (e.g. those of overrunning strategies) are not waited for
+            _exit(status);
+        }
+        ::close(fd[1]);
+        ffd = fd[0];
+    }
+
+    tchildprocess(const tchildprocess&) = delete;
+    tchildprocess& operator=(const tchildprocess&) = delete;
+
+    ~tchildprocess()
+    {
+        if(ffd >= 0)
+        {
+            ::kill(fpid, SIGKILL);
+            std::string dummy;
+            finish(dummy);
+        }
+    }
+
+    /// waits for the child to end, its output is returned in \p output
+    /// \return empty string if the child succeeded, otherwise the reason of the failure
+    std::string finish(std::string& output)
+    {
+        char buf[4096];
+        bool timedout = false;
+        for(;;)
+        {
+            if(fwalltime)
+            {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  std::chrono::steady_clock::now() - fstart).count();
+                long long left = fwalltime * 1000LL - elapsed;
+                pollfd p = { ffd, POLLIN, 0 };
+                int pr = left > 0 ? ::poll(&p, 1, static_cast<int>(left)) : 0;
+                if(pr < 0 && errno == EINTR)
+                    continue;
+                if(pr == 0)
+                {
+                    ::kill(fpid, SIGKILL);
+                    timedout = true;
+                    break;
+                }
+            }
+            auto r = ::read(ffd, buf, sizeof(buf));
+            if(r > 0)
+                output.append(buf, r);
+            else if(r < 0 && errno == EINTR)
+                continue;
+            else
+                break;
+        }
+        ::close(ffd);
+        ffd = -1;
+        int status = 0;
+        while(waitpid(fpid, &status, 0) < 0)
+            if(errno != EINTR)
+                return std::string("waitpid failed: ") + strerror(errno);
+        if(timedout)
+            return "wall time limit exceeded";
+        if(WIFSIGNALED(status))
+        {
+            int s = WTERMSIG(status);
+            if(s == SIGXCPU)
+                return "CPU time limit exceeded";
+            std::ostringstream e;
+            e << "terminated by signal " << s << " (" << strsignal(s) << ")";
+            return e.str();
+        }
+        if(WEXITSTATUS(status) != 0)
+        {
+            std::ostringstream e;
+            e << "exited with status " << WEXITSTATUS(status);
+            return e.str();
+        }
+        return "";
+    }
+
+private:
+    static void setlimits(const tprocesslimits& limits)
+    {
+        if(limits.cputime)
+        {
+            // SIGXCPU at the soft limit, SIGKILL one second later if it is ignored
+            rlimit l = { limits.cputime, limits.cputime + 1 };
+            setrlimit(RLIMIT_CPU, &l);
+        }
+        if(limits.memory)
+        {
+            rlimit l = { limits.memory, limits.memory };
+            setrlimit(RLIMIT_AS, &l);
+        }
+    }
+
+    pid_t fpid = -1;
+    int ffd = -1;
+    std::chrono::steady_clock::time_point fstart;
+    unsigned fwalltime = 0;
+};
+
+} // namespace
+
+#endif // PROCESS_HPP
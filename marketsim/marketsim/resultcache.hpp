@@ -0,0 +1,81 @@
+#ifndef RESULTCACHE_HPP
+#define RESULTCACHE_HPP
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
+#include <filesystem>
+#include "marketsim/checkpoint.hpp"
+
+namespace marketsim
+{
+
+/// 64-bit FNV-1a hash of \p s
+inline unsigned long long fnv1ahash(const std::string& s)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    for(unsigned char c: s)
+    {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/// On-disk cache of results keyed by their content. An entry is stored in a file named
+/// by the hash of its key, together with the key, so that a collision is recognized as
+/// a missing entry.
+class tresultcache
+{
+public:
+    /// constructor, the entries are in directory \p dir (created if needed)
+    tresultcache(const std::string& dir) : fdir(dir)
+    {
+        std::error_code e;
+        std::filesystem::create_directories(fdir, e);
+    }
+
+    /// looks up entry \p key, if present, its value is returned in \p value
+    bool load(const std::string& key, std::string& value) const
+    {
+        std::ifstream f(filename(key), std::ios::binary);
+        if(!f)
+            return false;
+        std::string k;
+        loadbinary(f,k);
+        loadbinary(f,value);
+        return f && k == key;
+    }
+
+    /// stores entry \p key with value \p value (the file is written aside and renamed,
+    /// so that an interrupted program does not leave a corrupted entry)
+    void store(const std::string& key, const std::string& value) const
+    {
+        std::string name = filename(key);
+        std::string tmp = name + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary);
+            savebinary(f,key);
+            savebinary(f,value);
+            if(!f)
+                return;
+        }
+        std::rename(tmp.c_str(), name.c_str());
+    }
+
+private:
+    std::string filename(const std::string& key) const
+    {
+        std::ostringstream s;
+        s << std::hex << std::setw(16) << std::setfill('0') << fnv1ahash(key);
+        return (std::filesystem::path(fdir) / (s.str() + ".run")).string();
+    }
+
+    std::string fdir;
+};
+
+} // namespace
+
+#endif // RESULTCACHE_HPP
@@ -0,0 +1,324 @@
+#ifndef RESULTSINK_HPP
+#define RESULTSINK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <istream>
+#include <ostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+#include "marketsim/checkpoint.hpp"
+
+namespace marketsim
+{
+
+/// result of a strategy in a run of a competition
+struct tresultrecord
+{
+    /// index of the run
+    std::uint32_t turn;
+    /// index of the strategy
+    std::uint32_t strategy;
+    /// consumption
+    double c;
+    /// money at the end of the run
+    std::int64_t m;
+    /// stocks at the end of the run
+    std::int64_t s;
+    /// the last defined price (NaN if there was none)
+    double lastp;
+};
+
+/// Destination of the results of individual runs of a competition.
+class tresultsink
+{
+public:
+    virtual ~tresultsink() {}
+    /// called before the first record, the competing strategies are named \p names
+    virtual void begin(const std::vector<std::string>& names) = 0;
+    /// writes record \p r
+    virtual void add(const tresultrecord& r) = 0;
+    /// called after the last record
+    virtual void end() {}
+};
+
+/// marketsim::tresultsink writing text CSV with columns \c turn, \c id (the name of
+/// the strategy followed by its index), \c c, \c m, \c s and \c lastp
+class tcsvresultsink : public tresultsink
+{
+public:
+    /// constructor, the CSV is written to \p o
+    tcsvresultsink(std::ostream& o) : fo(o) {}
+
+    virtual void begin(const std::vector<std::string>& names)
+    {
+        fnames = names;
+        fo << "turn,id,c,m,s,lastp" << std::endl;
+    }
+
+    virtual void add(const tresultrecord& r)
+    {
+        fo << r.turn << "," << fnames[r.strategy] << r.strategy << ","
+           << r.c << "," << r.m << "," << r.s << ",";
+        if(!std::isnan(r.lastp))
+            fo << r.lastp;
+        fo << std::endl;
+    }
+
+private:
+    std::ostream& fo;
+    std::vector<std::string> fnames;
+};
+
+/// Reads records written by marketsim::tcsvresultsink (in the same way as
+/// marketsim::tbinaryresultreader).
+class tcsvresultreader
+{
+public:
+    /// constructor, reads the header from \p i, the competing strategies are named \p names
+    /// (the file identifies them by the names followed by their indices)
+    /// \throw std::runtime_error if \p i is not in the format of marketsim::tcsvresultsink
+    /// or two of the strategies have the same identification (e.g. \c a1 at index 1 and
+    /// \c a at index 11, both identified by \c a11)
+    tcsvresultreader(std::istream& i, const std::vector<std::string>& names)
+        : fi(i), fnames(names)
+    {
+        for(std::uint32_t j=0; j<fnames.size(); j++)
+            if(!fids.emplace(fnames[j] + std::to_string(j), j).second)
+                throw std::runtime_error("Ambiguous strategy in marketsim CSV result file: "
+                                         + fnames[j] + std::to_string(j));
+        std::string h;
+        if(!std::getline(i,h) || h != "turn,id,c,m,s,lastp")
+            throw std::runtime_error("Not a marketsim CSV result file");
+    }
+
+    /// names of the strategies
+    const std::vector<std::string>& names() const { return fnames; }
+
+    /// reads the next record to \p r, \return \c false if there is none
+    /// \throw std::runtime_error if the line is not a record
+    bool next(tresultrecord& r)
+    {
+        std::string l;
+        if(!std::getline(fi,l) || l.empty())
+            return false;
+        std::vector<std::string> fs;
+        std::istringstream ls(l);
+        for(std::string f; std::getline(ls,f,','); )
+            fs.push_back(f);
+        // the last field is empty if there was no defined price
+        if(l.back() == ',')
+            fs.push_back("");
+        if(fs.size() != 6)
+            throw std::runtime_error("Corrupted marketsim CSV result file: " + l);
+        auto id = fids.find(fs[1]);
+        if(id == fids.end())
+            throw std::runtime_error("Unknown strategy in marketsim CSV result file: " + fs[1]);
+        r.strategy = id->second;
+        try
+        {
+            r.turn = static_cast<std::uint32_t>(std::stoul(fs[0]));
+            r.c = std::stod(fs[2]);
+            r.m = std::stoll(fs[3]);
+            r.s = std::stoll(fs[4]);
+            r.lastp = fs[5].empty() ? std::numeric_limits<double>::quiet_NaN() : std::stod(fs[5]);
+        }
+        catch(std::logic_error&)
+        {
+            throw std::runtime_error("Corrupted marketsim CSV result file: " + l);
+        }
+        return true;
+    }
+
+private:
+    std::istream& fi;
+    std::vector<std::string> fnames;
+    /// indices of the strategies by their identifications in the file
+    std::map<std::string,std::uint32_t> fids;
+};
+
+/// format of the result shards of marketsim::competitiongrid
+enum class tresultformat
+{
+    /// marketsim::tcsvresultsink
+    csv,
+    /// marketsim::tbinaryresultsink
+    binary
+};
+
+/// Binary format of marketsim::tbinaryresultsink: magic, version, the schema (number of
+/// columns, names and type codes of the columns), the names of the strategies and
+/// fixed-width records (little endian as written by the machine, the doubles exact).
+struct tbinaryresultformat
+{
+    static constexpr char magic[4] = {'M','S','R','S'};
+    static constexpr std::uint32_t version = 1;
+    /// type codes of the columns
+    enum ttype : char { uint32 = 'u', int64 = 'i', float64 = 'd' };
+
+    static std::vector<std::pair<std::string,ttype>> schema()
+    {
+        return { {"turn",uint32}, {"strategy",uint32}, {"c",float64},
+                 {"m",int64}, {"s",int64}, {"lastp",float64} };
+    }
+
+    /// size of a record
+    static constexpr unsigned recordsize = 4 + 4 + 8 + 8 + 8 + 8;
+};
+
+/// marketsim::tresultsink writing marketsim::tbinaryresultformat, records can be converted to
+/// CSV by marketsim::binaryresultstocsv
+class tbinaryresultsink : public tresultsink
+{
+public:
+    /// constructor, the records are written to binary stream \p o
+    tbinaryresultsink(std::ostream& o) : fo(o) {}
+
+    virtual void begin(const std::vector<std::string>& names)
+    {
+        fo.write(tbinaryresultformat::magic, sizeof(tbinaryresultformat::magic));
+        savebinary(fo,tbinaryresultformat::version);
+        auto schema = tbinaryresultformat::schema();
+        savebinary(fo,static_cast<std::uint32_t>(schema.size()));
+        for(const auto& c: schema)
+        {
+            savebinary(fo,c.first);
+            savebinary(fo,static_cast<char>(c.second));
+        }
+        savebinary(fo,static_cast<std::uint32_t>(names.size()));
+        for(const auto& n: names)
+            savebinary(fo,n);
+    }
+
+    virtual void add(const tresultrecord& r)
+    {
+        // field by field, so that the records have no padding
+        char b[tbinaryresultformat::recordsize];
+        char* p = b;
+        put(p,r.turn);
+        put(p,r.strategy);
+        put(p,r.c);
+        put(p,r.m);
+        put(p,r.s);
+        put(p,r.lastp);
+        fo.write(b, sizeof(b));
+    }
+
+    virtual void end() { fo.flush(); }
+
+private:
+    template <typename T>
+    static void put(char*& p, const T& x)
+    {
+        std::copy(reinterpret_cast<const char*>(&x), reinterpret_cast<const char*>(&x) + sizeof(T), p);
+        p += sizeof(T);
+    }
+
+    std::ostream& fo;
+};
+
+/// Reads records written by marketsim::tbinaryresultsink.
+class tbinaryresultreader
+{
+public:
+    /// constructor, reads the header from binary stream \p i
+    /// \throw std::runtime_error if \p i is not in marketsim::tbinaryresultformat
+    tbinaryresultreader(std::istream& i) : fi(i)
+    {
+        char m[sizeof(tbinaryresultformat::magic)];
+        std::uint32_t v = 0;
+        if(!i.read(m, sizeof(m))
+                || !std::equal(m, m + sizeof(m), tbinaryresultformat::magic))
+            throw std::runtime_error("Not a marketsim binary result file");
+        loadbinary(i,v);
+        if(v != tbinaryresultformat::version)
+            throw std::runtime_error("Unsupported version of marketsim binary result file");
+        std::uint32_t n = 0;
+        loadbinary(i,n);
+        auto schema = tbinaryresultformat::schema();
+        bool ok = n == schema.size();
+        for(std::uint32_t k=0; k<n && i; k++)
+        {
+            std::string name;
+            char type = 0;
+            loadbinary(i,name);
+            loadbinary(i,type);
+            ok = ok && name == schema[k].first && type == schema[k].second;
+        }
+        if(!ok)
+            throw std::runtime_error("Unsupported schema of marketsim binary result file");
+        loadbinary(i,n);
+        for(std::uint32_t k=0; k<n && i; k++)
+        {
+            std::string name;
+            loadbinary(i,name);
+            fnames.push_back(name);
+        }
+        if(!i)
+            throw std::runtime_error("Corrupted marketsim binary result file");
+    }
+
+    /// names of the strategies
+    const std::vector<std::string>& names() const { return fnames; }
+
+    /// reads the next record to \p r, \return \c false if there is none
+    /// \throw std::runtime_error if the stream ends inside a record or
+    /// the record refers to an unknown strategy
+    bool next(tresultrecord& r)
+    {
+        char b[tbinaryresultformat::recordsize];
+        if(!fi.read(b, sizeof(b)))
+        {
+            if(fi.gcount() == 0)
+                return false;
+            throw std::runtime_error("Truncated record in marketsim binary result file");
+        }
+        const char* p = b;
+        get(p,r.turn);
+        get(p,r.strategy);
+        get(p,r.c);
+        get(p,r.m);
+        get(p,r.s);
+        get(p,r.lastp);
+        if(r.strategy >= fnames.size())
+            throw std::runtime_error("Unknown strategy in marketsim binary result file: "
+                                     + std::to_string(r.strategy));
+        return true;
+    }
+
+private:
+    template <typename T>
+    static void get(const char*& p, T& x)
+    {
+        std::copy(p, p + sizeof(T), reinterpret_cast<char*>(&x));
+        p += sizeof(T);
+    }
+
+    std::istream& fi;
+    std::vector<std::string> fnames;
+};
+
+/// converts records written by marketsim::tbinaryresultsink in binary stream \p i
+/// to CSV in the format of marketsim::tcsvresultsink, written to \p o
+/// (doubles are written with \p precision digits)
+inline void binaryresultstocsv(std::istream& i, std::ostream& o, int precision = 17)
+{
+    tbinaryresultreader r(i);
+    auto p = o.precision(precision);
+    tcsvresultsink csv(o);
+    csv.begin(r.names());
+    tresultrecord rec;
+    while(r.next(rec))
+        csv.add(rec);
+    csv.end();
+    o.precision(p);
+}
+
+} // namespace
+
+#endif // RESULTSINK_HPP
@@ -0,0 +1,265 @@
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <math.h>
+#include "marketsim/checkpoint.hpp"
+
+namespace marketsim
+{
+
+/// class used to collect statistical information (TBD move to orpp): the moments are
+/// updated by Welford's method, so they are stable also for large values, and two
+/// counters can be merged (Chan et al.), e.g. those of parallel workers
+struct statcounter
+{
+    unsigned num = 0;
+    /// running mean
+    double mean = 0.0;
+    /// running sum of squared deviations from the mean
+    double m2 = 0.0;
+
+    void add(double x)
+    {
+        num++;
+        double d = x - mean;
+        mean += d / num;
+        m2 += d * (x - mean);
+    }
+
+    /// adds the observations of \p s
+    void merge(const statcounter& s)
+    {
+        if(!s.num)
+            return;
+        double n = static_cast<double>(num) + s.num;
+        double d = s.mean - mean;
+        mean += d * s.num / n;
+        m2 += s.m2 + d * d * num * s.num / n;
+        num += s.num;
+    }
+
+    /// mean of the observations (0/0 if there are none)
+    double average() const { return num ? mean : mean / num; }
+    /// variance of the observations (divided by their number)
+    double var() const { return m2 / num; }
+    double averagevar() const  { return var() / num; }
+};
+
+/// Bounded-memory mergeable sketch of a distribution of observations (merging t-digest):
+/// the observations are kept in centroids (means with weights) whose sizes are limited
+/// by the scale function k1, so the tails are represented (almost) exactly and the number
+/// of centroids stays of order of \p compression regardless of the number of observations.
+/// The sketch is deterministic, so the same observations added (merged) in the same
+/// order give the same quantiles.
+class tquantilesketch
+{
+public:
+    /// constructor, \p compression bounds the number of centroids
+    tquantilesketch(double compression = 100) : fcompression(compression) {}
+
+    /// adds observation \p x with weight \p w
+    void add(double x, double w = 1)
+    {
+        if(isnan(x))
+            return;
+        fbuffer.push_back({x,w});
+        if(fbuffer.size() >= buffersize())
+            compress();
+    }
+
+    /// adds the observations of \p s
+    void merge(const tquantilesketch& s)
+    {
+        fbuffer.insert(fbuffer.end(), s.fcentroids.begin(), s.fcentroids.end());
+        fbuffer.insert(fbuffer.end(), s.fbuffer.begin(), s.fbuffer.end());
+        compress();
+    }
+
+    /// total weight of the observations
+    double weight() const
+    {
+        compress();
+        return ftotal;
+    }
+
+    /// \p q-quantile of the observations (interpolated between the centroids,
+    /// NaN if there are none)
+    double quantile(double q) const
+    {
+        compress();
+        if(fcentroids.empty())
+            return std::numeric_limits<double>::quiet_NaN();
+        if(fcentroids.size() == 1)
+            return fcentroids[0].mean;
+        double t = std::min(1.0, std::max(0.0, q)) * ftotal;
+        // the centroids are placed in the middles of their weights,
+        // the extremes at the ends
+        double prevpos = 0;
+        double prevx = fmin;
+        double cum = 0;
+        for(const auto& c: fcentroids)
+        {
+            double pos = cum + c.weight / 2;
+            if(t <= pos)
+                return interpolate(prevpos, prevx, pos, c.mean, t);
+            prevpos = pos;
+            prevx = c.mean;
+            cum += c.weight;
+        }
+        return interpolate(prevpos, prevx, ftotal, fmax, t);
+    }
+
+    /// mean of the lower \p alpha fraction of the observations (lower conditional
+    /// value at risk, NaN if there are none)
+    double lowerCVaR(double alpha) const
+    {
+        compress();
+        double limit = std::min(1.0, std::max(0.0, alpha)) * ftotal;
+        if(fcentroids.empty() || limit <= 0)
+            return std::numeric_limits<double>::quiet_NaN();
+        double sum = 0;
+        double psum = 0;
+        for(const auto& c: fcentroids)
+        {
+            double w = std::min(c.weight, limit - psum);
+            sum += w * c.mean;
+            psum += w;
+            if(psum >= limit)
+                break;
+        }
+        return sum / psum;
+    }
+
+    /// writes the sketch to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        compress();
+        savebinary(o,fcompression);
+        savebinary(o,fcentroids);
+        savebinary(o,ftotal);
+        savebinary(o,fmin);
+        savebinary(o,fmax);
+    }
+
+    /// reads the sketch written by marketsim::tquantilesketch::save
+    void load(std::istream& i)
+    {
+        loadbinary(i,fcompression);
+        loadbinary(i,fcentroids);
+        loadbinary(i,ftotal);
+        loadbinary(i,fmin);
+        loadbinary(i,fmax);
+        fbuffer.clear();
+    }
+
+private:
+    struct tcentroid
+    {
+        double mean;
+        double weight;
+    };
+
+    static double interpolate(double x0, double y0, double x1, double y1, double x)
+    {
+        return x1 > x0 ? y0 + (y1 - y0) * (x - x0) / (x1 - x0) : y1;
+    }
+
+    size_t buffersize() const { return static_cast<size_t>(5 * fcompression) + 1; }
+
+    /// scale function k1 and its inverse
+    double k(double q) const { return fcompression / (2 * M_PI) * asin(2 * q - 1); }
+    double kinv(double k) const { return (sin(k * 2 * M_PI / fcompression) + 1) / 2; }
+
+    /// merges the buffer into the centroids
+    void compress() const
+    {
+        if(fbuffer.empty())
+            return;
+        fbuffer.insert(fbuffer.end(), fcentroids.begin(), fcentroids.end());
+        std::stable_sort(fbuffer.begin(), fbuffer.end(),
+                         [](const tcentroid& a, const tcentroid& b) { return a.mean < b.mean; });
+        double total = 0;
+        for(const auto& c: fbuffer)
+            total += c.weight;
+        fmin = std::min(fmin, fbuffer.front().mean);
+        fmax = std::max(fmax, fbuffer.back().mean);
+
+        fcentroids.clear();
+        tcentroid cur = fbuffer[0];
+        double sofar = 0;
+        double limit = total * kinv(k(0) + 1);
+        for(size_t j=1; j<fbuffer.size(); j++)
+        {
+            const tcentroid& c = fbuffer[j];
+            if(sofar + cur.weight + c.weight <= limit)
+            {
+                cur.weight += c.weight;
+                cur.mean += (c.mean - cur.mean) * c.weight / cur.weight;
+            }
+            else
+            {
+                sofar += cur.weight;
+                fcentroids.push_back(cur);
+                limit = total * kinv(k(sofar / total) + 1);
+                cur = c;
+            }
+        }
+        fcentroids.push_back(cur);
+        ftotal = total;
+        fbuffer.clear();
+    }
+
+    double fcompression;
+    mutable std::vector<tcentroid> fcentroids;
+    mutable std::vector<tcentroid> fbuffer;
+    mutable double ftotal = 0;
+    mutable double fmin = std::numeric_limits<double>::infinity();
+    mutable double fmax = -std::numeric_limits<double>::infinity();
+};
+
+/// marketsim::statcounter also keeping marketsim::tquantilesketch of the observations
+struct distributioncounter : public statcounter
+{
+    void add(double x)
+    {
+        statcounter::add(x);
+        sketch.add(x);
+    }
+
+    /// adds the observations of \p s
+    void merge(const distributioncounter& s)
+    {
+        statcounter::merge(s);
+        sketch.merge(s.sketch);
+    }
+
+    /// \p q-quantile of the observations
+    double quantile(double q) const { return sketch.quantile(q); }
+    /// mean of the lower \p alpha fraction of the observations
+    double lowerCVaR(double alpha) const { return sketch.lowerCVaR(alpha); }
+
+    /// writes the counter to binary stream \p o
+    void save(std::ostream& o) const
+    {
+        savebinary(o,static_cast<const statcounter&>(*this));
+        sketch.save(o);
+    }
+
+    /// reads the counter written by marketsim::distributioncounter::save
+    void load(std::istream& i)
+    {
+        loadbinary(i,static_cast<statcounter&>(*this));
+        sketch.load(i);
+    }
+
+    tquantilesketch sketch;
+};
+
+} // namespace
+
+#endif // STATISTICS_HPP
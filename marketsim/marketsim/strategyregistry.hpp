@@ -0,0 +1,117 @@
+#ifndef STRATEGYREGISTRY_HPP
+#define STRATEGYREGISTRY_HPP
+
+#include "marketsim.hpp"
+#include <map>
+#include <functional>
+#include <sstream>
+
+namespace marketsim
+{
+
+/// parameters of a strategy created by marketsim::tstrategyregistry (values by names)
+using tstrategyparams = std::map<std::string,double>;
+
+/// Factory of strategies parametrized at runtime: a strategy is created by its (registered)
+/// name and marketsim::tstrategyparams, so that the strategies of a parameter sweep
+/// do not need a template instance each.
+class tstrategyregistry
+{
+public:
+    /// creates the strategy from (complete) parameters
+    using tfactory = std::function<teventdrivenstrategy*(const tstrategyparams&)>;
+
+    /// registers strategy \p name created by \p factory, whose parameters
+    /// (and their default values) are \p defaults
+    void add(const std::string& name, const tstrategyparams& defaults, tfactory factory)
+    {
+        fentries[name] = { defaults, factory };
+    }
+
+    /// \c true if strategy \p name is registered
+    bool has(const std::string& name) const { return fentries.count(name); }
+
+    /// parameters of strategy \p name with their default values
+    const tstrategyparams& defaults(const std::string& name) const
+    {
+        return entry(name).defaults;
+    }
+
+    /// parameters \p params of strategy \p name completed by the default values
+    tstrategyparams complete(const std::string& name, const tstrategyparams& params) const
+    {
+        tstrategyparams ret = entry(name).defaults;
+        for(const auto& p: params)
+        {
+            if(!ret.count(p.first))
+                throw marketsimerror("Strategy " + name + " has no parameter " + p.first);
+            ret[p.first] = p.second;
+        }
+        return ret;
+    }
+
+    /// creates strategy \p name with parameters \p params (the missing ones
+    /// have their default values)
+    teventdrivenstrategy* create(const std::string& name, const tstrategyparams& params) const
+    {
+        return entry(name).factory(complete(name,params));
+    }
+
+private:
+    struct tentry
+    {
+        tstrategyparams defaults;
+        tfactory factory;
+    };
+
+    const tentry& entry(const std::string& name) const
+    {
+        auto it = fentries.find(name);
+        if(it == fentries.end())
+            throw marketsimerror("Unknown strategy " + name);
+        return it->second;
+    }
+
+    std::map<std::string,tentry> fentries;
+};
+
+/// Competitor (ED) creating strategy \p strategy of \p registry with parameters \p params.
+class registeredcompetitor : public competitorbase<false>
+{
+public:
+    /// constructor, the competitor is named \p name, \p registry has to outlive it
+    registeredcompetitor(const tstrategyregistry& registry, const std::string& strategy,
+                         const tstrategyparams& params, const std::string& name,
+                         bool nowarmup = false)
+        : fregistry(registry), fstrategy(strategy),
+          fparams(registry.complete(strategy,params)), fname(name), fnowarmup(nowarmup)
+    {}
+
+    virtual teventdrivenstrategy* create() { return fregistry.create(fstrategy,fparams); }
+    virtual std::string name() const { return fname; }
+    virtual bool startswithoutwarmup() const { return fnowarmup; }
+    /// the strategy and its parameters
+    virtual std::string key() const
+    {
+        std::ostringstream s;
+        s.precision(17);
+        s << fstrategy;
+        for(const auto& p: fparams)
+            s << "," << p.first << "=" << p.second;
+        return s.str();
+    }
+
+    /// parameters of the strategy (including the default ones)
+    const tstrategyparams& params() const { return fparams; }
+
+private:
+    const tstrategyregistry& fregistry;
+    std::string fstrategy;
+    tstrategyparams fparams;
+    std::string fname;
+    bool fnowarmup;
+};
+
+} // namespace
+
+#endif // STRATEGYREGISTRY_HPP
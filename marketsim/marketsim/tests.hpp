@@ -83,6 +83,117 @@ inline std::shared_ptr<tmarketdata> test(std::vector<competitorbase<chronos>*> c
     return test<chronos,calibrate,logging,allowlearning, D>(competitors,runningtime, std::vector<twallet>(competitors.size(),endowment),adef,aseed,os);
 }
 
+/// Checks that the parallel ED simulation (see marketsim::tmarketdef::edthreads) reproduces
+/// the serial one: runs \p competitors with \p adef and with \p adef modified to one thread,
+/// both with zero computation times (see marketsim::tmarketdef::comptimemodel), and compares
+/// the wallets, consumptions, numbers of events, the snapshots of the market and the trades
+/// of the strategies. The differences are
+/// reported to \p os. Returns \c true if there are none (with
+/// marketsim::tmarketdef::edfrozenmarket, differences are expected).
+template <bool allowlearning = false, typename D = tnodemandsupply>
+inline bool edparallelequalsserial(std::vector<competitorbase<false>*> competitors,
+                 tabstime runningtime,
+                 std::vector<twallet> endowments,
+                 const tmarketdef& adef,
+                 int aseed = 0,
+                 std::ostream& os = std::clog)
+{
+    auto run = [&](unsigned threads)
+    {
+        tmarketdef def = adef;
+        def.edthreads = threads;
+        def.comptimemodel = tcomptimemodel();
+        def.comptimemodel.scale = 0;
+        tmarket m(runningtime,def);
+        if(aseed != 0)
+            m.seed(aseed);
+        std::vector<tstrategy*> garbage;
+        m.run<false,D,allowlearning>(competitors,endowments,garbage);
+        return m.results();
+    };
+
+    auto s = run(1);
+    auto p = run(adef.edthreads);
+    bool ok = true;
+    for(unsigned i=0; i<competitors.size(); i++)
+    {
+        const auto& si = s->fstrategyinfos[i];
+        const auto& pi = p->fstrategyinfos[i];
+        if(si.wallet().money() != pi.wallet().money()
+                || si.wallet().stocks() != pi.wallet().stocks()
+                || si.totalconsumption() != pi.totalconsumption()
+                || si.comptimes().num != pi.comptimes().num)
+        {
+            os << "Strategy " << i << " " << si.name() << " differs: serial wallet ";
+            si.wallet().output(os);
+            os << " consumption " << si.totalconsumption() << " events " << si.comptimes().num
+               << ", parallel wallet ";
+            pi.wallet().output(os);
+            os << " consumption " << pi.totalconsumption() << " events " << pi.comptimes().num
+               << std::endl;
+            ok = false;
+        }
+    }
+    const auto& sx = s->fhistory.x();
+    const auto& px = p->fhistory.x();
+    for(unsigned k=0; k<std::max(sx.size(),px.size()); k++)
+        if(k >= sx.size() || k >= px.size()
+              || sx[k].t != px[k].t || sx[k].b != px[k].b || sx[k].a != px[k].a
+              || sx[k].q != px[k].q || sx[k].Bvol != px[k].Bvol || sx[k].Avol != px[k].Avol)
+        {
+            os << "Histories differ from snapshot " << k << " (" << sx.size() << " serial and "
+               << px.size() << " parallel snapshots)" << std::endl;
+            ok = false;
+            break;
+        }
+    for(unsigned i=0; i<competitors.size(); i++)
+    {
+        const auto& st = s->fstrategyinfos[i].tradinghistory().x();
+        const auto& pt = p->fstrategyinfos[i].tradinghistory().x();
+        for(unsigned k=0; k<std::max(st.size(),pt.size()); k++)
+            if(k >= st.size() || k >= pt.size()
+                  || st[k].t != pt[k].t || st[k].moneydelta != pt[k].moneydelta
+                  || st[k].stockdelta != pt[k].stockdelta || st[k].partner != pt[k].partner)
+            {
+                os << "Trading histories of strategy " << i << " differ from trade " << k
+                   << " (" << st.size() << " serial and " << pt.size() << " parallel trades)"
+                   << std::endl;
+                ok = false;
+                break;
+            }
+    }
+    return ok;
+}
+
+template <bool allowlearning = false, typename D = tnodemandsupply>
+inline bool edparallelequalsserial(std::vector<competitorbase<false>*> competitors,
+                 tabstime runningtime,
+                 const twallet& endowment,
+                 const tmarketdef& adef,
+                 int aseed = 0,
+                 std::ostream& os = std::clog)
+{
+    return edparallelequalsserial<allowlearning,D>(competitors,runningtime,
+               std::vector<twallet>(competitors.size(),endowment),adef,aseed,os);
+}
+
+/// Checks that the optimistic ED simulation (see marketsim::tmarketdef::edoptimistic)
+/// reproduces the serial one, see marketsim::edparallelequalsserial.
+template <bool allowlearning = false, typename D = tnodemandsupply>
+inline bool edoptimisticequalsserial(std::vector<competitorbase<false>*> competitors,
+                 tabstime runningtime,
+                 std::vector<twallet> endowments,
+                 const tmarketdef& adef,
+                 int aseed = 0,
+                 std::ostream& os = std::clog)
+{
+    tmarketdef def = adef;
+    def.edoptimistic = true;
+    if(def.edthreads == 1)
+        def.edthreads = 0;
+    return edparallelequalsserial<allowlearning,D>(competitors,runningtime,endowments,def,aseed,os);
+}
+
 
 } // namespace
 
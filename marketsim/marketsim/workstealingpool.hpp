@@ -0,0 +1,153 @@
+#ifndef WORKSTEALINGPOOL_HPP
+#define WORKSTEALINGPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+namespace marketsim
+{
+
+/// Fork-join pool of threads with per-thread task queues. A batch passed to
+/// marketsim::tworkstealingpool::run is dealt round robin into the queues, each thread
+/// takes tasks from the back of its own queue and, when it is empty, steals from the front
+/// of the other ones, so that a few long tasks do not leave the other threads idle.
+class tworkstealingpool
+{
+public:
+    /// constructor, \p nthreads is the number of threads including the caller of
+    /// marketsim::tworkstealingpool::run (0 means the number of cores)
+    tworkstealingpool(unsigned nthreads = 0)
+    {
+        if(nthreads == 0)
+            nthreads = std::max(1u, std::thread::hardware_concurrency());
+        for(unsigned i=0; i<nthreads; i++)
+            fqueues.emplace_back(new tqueue);
+        for(unsigned i=1; i<nthreads; i++)
+            fthreads.emplace_back(&tworkstealingpool::worker, this, i);
+    }
+
+    /// joins the threads
+    ~tworkstealingpool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(fmutex);
+            fstop = true;
+        }
+        fcv.notify_all();
+        for(auto& t: fthreads)
+            t.join();
+    }
+
+    tworkstealingpool(const tworkstealingpool&) = delete;
+    tworkstealingpool& operator=(const tworkstealingpool&) = delete;
+
+    /// number of threads (including the caller)
+    unsigned size() const { return fqueues.size(); }
+
+    /// runs all the \p tasks and returns after they have finished; the calling thread takes part.
+    /// The tasks must not throw.
+    void run(const std::vector<std::function<void()>>& tasks)
+    {
+        if(tasks.size() == 0)
+            return;
+        // set before any task is visible, threads of the previous batch may still be looking for work
+        fremaining = tasks.size();
+        for(unsigned i=0; i<tasks.size(); i++)
+        {
+            auto& q = *fqueues[i % fqueues.size()];
+            std::lock_guard<std::mutex> lock(q.m);
+            q.q.push_back(&tasks[i]);
+        }
+        {
+            std::lock_guard<std::mutex> lock(fmutex);
+            fgeneration++;
+        }
+        fcv.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(fmutex);
+        fdonecv.wait(lock, [this]() { return fremaining == 0; });
+    }
+
+private:
+    struct tqueue
+    {
+        std::mutex m;
+        std::deque<const std::function<void()>*> q;
+    };
+
+    bool pop(unsigned self, const std::function<void()>*& task)
+    {
+        {
+            auto& q = *fqueues[self];
+            std::lock_guard<std::mutex> lock(q.m);
+            if(q.q.size())
+            {
+                task = q.q.back();
+                q.q.pop_back();
+                return true;
+            }
+        }
+        for(unsigned k=1; k<fqueues.size(); k++)
+        {
+            auto& q = *fqueues[(self + k) % fqueues.size()];
+            std::lock_guard<std::mutex> lock(q.m);
+            if(q.q.size())
+            {
+                task = q.q.front();
+                q.q.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(unsigned self)
+    {
+        const std::function<void()>* task;
+        while(pop(self,task))
+        {
+            (*task)();
+            if(--fremaining == 0)
+            {
+                std::lock_guard<std::mutex> lock(fmutex);
+                fdonecv.notify_all();
+            }
+        }
+    }
+
+    void worker(unsigned self)
+    {
+        unsigned generation = 0;
+        for(;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(fmutex);
+                fcv.wait(lock, [this,generation]() { return fstop || fgeneration != generation; });
+                if(fstop)
+                    return;
+                generation = fgeneration;
+            }
+            work(self);
+        }
+    }
+
+    std::vector<std::unique_ptr<tqueue>> fqueues;
+    std::vector<std::thread> fthreads;
+    std::mutex fmutex;
+    std::condition_variable fcv;
+    std::condition_variable fdonecv;
+    std::atomic<unsigned> fremaining = 0;
+    unsigned fgeneration = 0;
+    bool fstop = false;
+};
+
+} // namespace
+
+#endif // WORKSTEALINGPOOL_HPP
@@ -9,30 +9,36 @@
 namespace marketsim
 {
 
-template <bool chronos=true, bool logging = false, bool cancelling = true>
-inline void dsmaslovcompetition(std::vector<competitorbase<chronos>*> acompetitors,
+/// demand/supply generator of marketsim::dsmaslovcompetition
+using dsmaslovcompetitionds = fairpriceds<3600,10>;
+
+/// cell of marketsim::competitiongrid evaluating the competition of
+/// marketsim::dsmaslovcompetition (to be evaluated with marketsim::dsmaslovcompetitionds)
+template <bool chronos=true, bool cancelling = true>
+inline tcompetitioncell<chronos> dsmaslovcompetitioncell(std::vector<competitorbase<chronos>*> acompetitors,
                                   twallet endowment,
-                                  const tcompetitiondef& adef,
-                                  std::ostream& protocol)
+                                  const tcompetitiondef& adef)
 {
-    std::vector<competitorbase<chronos>*> competitors = acompetitors;
-    std::vector<twallet> endowments(acompetitors.size(),endowment);
-
-    competitor<initialstrategy<90,100>,chronos,true> initial("initial");
-    competitors.push_back(&initial);
-    endowments.push_back(twallet::infinitewallet());
-
-    competitor<maslovorderplacer<100>,chronos,true> op("orderplacer");
-    competitor<cancellingmaslovorderplacer<100,100>,chronos,true> cop("corderplacer");
+    tcompetitioncell<chronos> cell(adef);
+    cell.add(acompetitors,endowment);
+    cell.template add<initialstrategy<90,100>,true>("initial",twallet::infinitewallet());
 
     if(cancelling)
-        competitors.push_back(&cop);
+        cell.template add<cancellingmaslovorderplacer<100,100>,true>
+                          ("corderplacer",twallet::emptywallet());
     else
-        competitors.push_back(&op);
-
-    endowments.push_back(twallet::emptywallet());
+        cell.template add<maslovorderplacer<100>,true>("orderplacer",twallet::emptywallet());
+    return cell;
+}
 
-    competition<chronos,true,logging,fairpriceds<3600,10>>(competitors,endowments,adef,protocol);
+template <bool chronos=true, bool logging = false, bool cancelling = true>
+inline void dsmaslovcompetition(std::vector<competitorbase<chronos>*> acompetitors,
+                                  twallet endowment,
+                                  const tcompetitiondef& adef,
+                                  std::ostream& protocol)
+{
+    competitiongrid<chronos,true,logging,dsmaslovcompetitionds>(
+         {dsmaslovcompetitioncell<chronos,cancelling>(acompetitors,endowment,adef)},protocol);
 }
 
 
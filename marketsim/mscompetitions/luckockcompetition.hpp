@@ -9,26 +9,28 @@
 namespace marketsim
 {
 
+/// cell of marketsim::competitiongrid evaluating the competition of marketsim::luckockcompetition
+template <bool chronos=true>
+inline tcompetitioncell<chronos> luckockcompetitioncell(std::vector<competitorbase<chronos>*> acompetitors,
+                                  twallet endowment,
+                                  const tcompetitiondef& adef)
+{
+    tcompetitioncell<chronos> cell(adef);
+    cell.add(acompetitors,endowment);
+    cell.template add<initialstrategy<90,110>,true>("initial",twallet::infinitewallet());
+    cell.template add<cancellinguniformluckockstrategy<1,200,360,3600,true>,true>
+                      ("luckock",twallet::infinitewallet());
+    return cell;
+}
+
 template <bool chronos=true, bool logging = false>
 inline void luckockcompetition(std::vector<competitorbase<chronos>*> acompetitors,
                                   twallet endowment,
                                   const tcompetitiondef& adef,
                                   std::ostream& protocol)
 {
-    std::vector<competitorbase<chronos>*> competitors = acompetitors;
-    std::vector<twallet> endowments(acompetitors.size(),endowment);
-
-    competitor<initialstrategy<90,110>,chronos,true> initial("initial");
-    competitors.push_back(&initial);
-    endowments.push_back(twallet::infinitewallet());
-
-    competitor<cancellinguniformluckockstrategy<1,200,360,3600,true>,
-                      chronos,true> cul("luckock");
-    competitors.push_back(&cul);
-
-    endowments.push_back(twallet::infinitewallet());
-
-    competition<chronos,true,logging>(competitors,endowments,adef,protocol);
+    competitiongrid<chronos,true,logging>(
+         {luckockcompetitioncell<chronos>(acompetitors,endowment,adef)},protocol);
 }
 
 
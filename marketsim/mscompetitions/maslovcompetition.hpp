@@ -7,24 +7,26 @@
 namespace marketsim
 {
 
+/// cell of marketsim::competitiongrid evaluating the competition of marketsim::maslovcompetition
+template <bool chronos=true>
+inline tcompetitioncell<chronos> maslovcompetitioncell(std::vector<competitorbase<chronos>*> acompetitors,
+                              twallet endowment,
+                                  const tcompetitiondef& adef)
+{
+    tcompetitioncell<chronos> cell(adef);
+    cell.add(acompetitors,endowment);
+    cell.template add<maslovstrategy,true>("maslov(internal)",twallet::infinitewallet());
+    return cell;
+}
+
 template <bool chronos=true, bool logging = false>
 inline void maslovcompetition(std::vector<competitorbase<chronos>*> acompetitors,
                               twallet endowment,
                                   const tcompetitiondef& adef,
                                   std::ostream& protocol)
 {
-    std::vector<competitorbase<chronos>*> competitors = acompetitors;
-
-    std::vector<twallet> endowments(acompetitors.size(),endowment);
-
-    competitor<maslovstrategy,chronos,true> cm("maslov(internal)");
-
-    endowments.push_back(twallet::infinitewallet());
-
-    competitors.push_back(&cm);
-
-    competition<chronos,true,logging>(competitors,endowments,adef,protocol);
-
+    competitiongrid<chronos,true,logging>(
+         {maslovcompetitioncell<chronos>(acompetitors,endowment,adef)},protocol);
 }
 
 
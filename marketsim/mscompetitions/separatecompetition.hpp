@@ -18,7 +18,10 @@ inline void separatecompetition(std::vector<competitorbase<false>*> acompetitors
     std::vector<statcounter> res;
     std::vector<statcounter> resv;
     tcompetitiondef def = adef;
+    // every pair of zi strategy and competitor is a cell with its own result shard
+    std::vector<tcompetitioncell<false>> cells;
     for(unsigned z=0; z<azistrategies.size(); z++)
+    {
         for(unsigned c=0; c<acompetitors.size(); c++)
         {
             std::ostringstream s;
@@ -26,15 +29,22 @@ inline void separatecompetition(std::vector<competitorbase<false>*> acompetitors
               << acompetitors[c]->name() << "_";
             def.id = s.str();
 
-            std::vector<competitorbase<false>*> arg;
-            arg.push_back(acompetitors[c]);
-            std::vector<competitionresult> r
-                    = zicompetition<false,logging>(
-                      arg,azistrategies[z],endowment,def, std::clog);
-            res.push_back(r[0].consumption);
-            resv.push_back(r[0].value);
-            def.seed++;
+            cells.push_back(zicompetitioncell<false>({acompetitors[c]},azistrategies[z],
+                                                      endowment,def));
+            // with independent random streams, the competitors face the same
+            // background (common random numbers), otherwise independent ones
+            if(!def.marketdef.independentrandomstreams)
+                def.seed++;
         }
+        // every zi strategy gets its own background
+        if(def.marketdef.independentrandomstreams)
+            def.seed++;
+    }
+    for(auto& r: competitiongrid<false,true,logging>(cells, std::clog))
+    {
+        res.push_back(r[0].consumption);
+        resv.push_back(r[0].value);
+    }
     std::ostream& o = std::cout;
 
     o << "Results of separate competition" << std::endl;
@@ -63,8 +73,12 @@ inline void separatecompetition(std::vector<competitorbase<false>*> acompetitors
     }
 }
 
+/// if \p cachedir is not empty, the runs are cached there (see
+/// marketsim::tcompetitiondef::cachedir), so reruns (e.g. with a new competitor)
+/// simulate only the runs not evaluated yet
 template <bool logging>
-inline void separatezicomp(std::vector<competitorbase<false>*> acompetitors)
+inline void separatezicomp(std::vector<competitorbase<false>*> acompetitors,
+                           const std::string& cachedir = "")
 {
     twallet endowment(5000,100);
     tmarketdef def;
@@ -73,11 +87,13 @@ inline void separatezicomp(std::vector<competitorbase<false>*> acompetitors)
 //        def.loggingfilter.fsettle = true;
 //        def.loggedstrategies.push_back(2);
     def.directlogging = true;
+    def.independentrandomstreams = true;
 //       def.demandupdateperiod = 0.1;
     tcompetitiondef cdef;
     cdef.timeofrun = 8*3600;
     cdef.samplesize = 10;
     cdef.marketdef = def;
+    cdef.cachedir = cachedir;
 
     competitor<cancellingmaslovstrategy<10,3600,360,30>> msf("maslovfast");
     competitor<cancellinguniformluckockstrategy<10,200,360,3600,false>> lsf("luckockfast");
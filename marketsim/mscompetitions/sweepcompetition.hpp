@@ -0,0 +1,75 @@
+#ifndef SWEEPCOMPETITION_HPP
+#define SWEEPCOMPETITION_HPP
+
+#include "marketsim/competition.hpp"
+#include "marketsim/strategyregistry.hpp"
+
+namespace marketsim
+{
+
+/// Parameter sweep of strategy \p strategy of \p registry: for each parameters of \p points,
+/// a competition of the strategy (with endowment \p endowment) against \p background (with
+/// endowments \p backgroundendowments) defined by \p adef is evaluated. The competitions form
+/// a single marketsim::competitiongrid, so all the runs (parameters times seeds) are
+/// evaluated in parallel as set by \p adef. A row of results (including the 5% quantile
+/// and the 5% lower CVaR of the consumption) is written to \p results as soon as
+/// the competition of a point is finished.
+/// \return the results of the competitions (the swept strategy is the first competitor)
+template <bool logging = false, typename D = tnodemandsupply>
+inline std::vector<std::vector<competitionresult>> sweepcompetition(
+        const tstrategyregistry& registry,
+        const std::string& strategy,
+        const std::vector<tstrategyparams>& points,
+        twallet endowment,
+        std::vector<competitorbase<false>*> background,
+        std::vector<twallet> backgroundendowments,
+        const tcompetitiondef& adef,
+        std::ostream& results)
+{
+    if(background.size() != backgroundendowments.size())
+        throw marketsimerror("sweepcompetition: background and its endowments do not match");
+
+    std::vector<std::unique_ptr<registeredcompetitor>> swept;
+    std::vector<tcompetitioncell<false>> cells;
+    for(unsigned k=0; k<points.size(); k++)
+    {
+        std::ostringstream s;
+        s << strategy << k;
+        swept.emplace_back(new registeredcompetitor(registry,strategy,points[k],s.str()));
+
+        tcompetitiondef def = adef;
+        std::ostringstream id;
+        id << adef.id << "sweep" << k << "_";
+        def.id = id.str();
+        tcompetitioncell<false> cell(def);
+        cell.add(swept.back().get(),endowment);
+        for(unsigned j=0; j<background.size(); j++)
+            cell.add(background[j],backgroundendowments[j]);
+        cells.push_back(cell);
+    }
+
+    const tstrategyparams& defaults = registry.defaults(strategy);
+    results << "point";
+    for(const auto& p: defaults)
+        results << "," << p.first;
+    results << ",c,csd,c05,ccvar05,v,vsd,nruns" << std::endl;
+
+    return competitiongrid<false,true,logging,D>(cells, std::clog,
+        [&](unsigned k, const std::vector<competitionresult>& r)
+        {
+            results << k;
+            for(const auto& p: swept[k]->params())
+                results << "," << p.second;
+            const statcounter& c = r[0].consumption;
+            const statcounter& v = r[0].value;
+            results << "," << c.average() << "," << sqrt(c.averagevar())
+                    << "," << r[0].consumption.quantile(0.05)
+                    << "," << r[0].consumption.lowerCVaR(0.05)
+                    << "," << v.average() << "," << sqrt(v.averagevar())
+                    << "," << r[0].nruns << std::endl;
+        });
+}
+
+} // namespace
+
+#endif // SWEEPCOMPETITION_HPP
@@ -7,6 +7,21 @@
 namespace marketsim
 {
 
+/// cell of marketsim::competitiongrid evaluating the competition of marketsim::zicompetition
+template <bool chronos=false>
+inline tcompetitioncell<chronos> zicompetitioncell(
+        std::vector<competitorbase<chronos>*> acompetitors,
+        competitorbase<chronos>* zicompetitor,
+        twallet endowment,
+        const tcompetitiondef& adef)
+{
+    tcompetitioncell<chronos> cell(adef);
+    cell.add(acompetitors,endowment);
+    cell.template add<initialstrategy<90,110>,true>("initial",twallet::infinitewallet());
+    cell.add(zicompetitor,twallet::infinitewallet());
+    return cell;
+}
+
 template <bool chronos=false, bool logging = false>
 std::vector<competitionresult> zicompetition(
         std::vector<competitorbase<chronos>*> acompetitors,
@@ -15,17 +30,8 @@ std::vector<competitionresult> zicompetition(
         const tcompetitiondef& adef,
         std::ostream& protocol)
 {
-    std::vector<competitorbase<chronos>*> competitors = acompetitors;
-    std::vector<twallet> endowments(acompetitors.size(),endowment);
-
-    competitor<initialstrategy<90,110>,chronos,true> initial("initial");
-    competitors.push_back(&initial);
-    endowments.push_back(twallet::infinitewallet());
-
-    competitors.push_back(zicompetitor);
-    endowments.push_back(twallet::infinitewallet());
-
-    return competition<chronos,true,logging>(competitors,endowments,adef,protocol);
+    return competitiongrid<chronos,true,logging>(
+         {zicompetitioncell<chronos>(acompetitors,zicompetitor,endowment,adef)},protocol)[0];
 }
 
 }
@@ -10,47 +10,64 @@ template <int eventsperhour, int volumemean, int volatilityperc = 30>
 class fairpriceds : public tdsbase
 {
 public:
-    fairpriceds() : lastt(0), pd(volumemean)
+    fairpriceds() : nextt(std::numeric_limits<tabstime>::max()), pd(volumemean)
     {}
+    /// called at the arrivals scheduled by fairpriceds::nextarrival
     virtual tdsrecord delta(tabstime t, const tmarketdata& md)
     {
         tdsrecord ret = {0,0};
-        if(t > lastt )
+        if(t >= nextt)
         {
-            constexpr double lambda = eventsperhour / 3600.0;
-            static_assert(lambda > 0);
-            double u = uniform();
-            if(-log(u)/lambda < (t-lastt))
+            bool buy = uniform() > 0.5;
+            auto volume = pd(engine());
+            if(volume)
             {
-                bool buy = uniform() > 0.5;
-                auto volume = pd(engine());
-                if(volume)
+                if(buy)
                 {
-                    if(buy)
+                    auto a = md.lastdefineda();
+                    if(a != khundefprice)
                     {
-                        auto a = md.lastdefineda();
-                        if(a != khundefprice)
-                        {
-                            ret = { volume * a,0 };
-                        }
+                        ret = { volume * a,0 };
                     }
-                    else
+                }
+                else
+                {
+                    auto b = md.lastdefinedb();
+                    if(b != klundefprice)
                     {
-                        auto b = md.lastdefinedb();
-                        if(b != klundefprice)
-                        {
-                            ret = { 0,volume };
-                        }
-
+                        ret = { 0,volume };
                     }
+
                 }
             }
-            lastt = t;
         }
         return ret;
     }
+
+    /// the arrivals form a Poisson process, the time to the next one is sampled
+    /// by the inverse of the exponential distribution function
+    virtual tabstime nextarrival(tabstime t)
+    {
+        constexpr double lambda = eventsperhour / 3600.0;
+        static_assert(lambda > 0);
+        nextt = t - log(1 - uniform()) / lambda;
+        return nextt;
+    }
+
+    virtual bool savestate(std::ostream& o) const
+    {
+        savebinary(o,nextt);
+        savetext(o,pd);
+        return true;
+    }
+
+    virtual void restorestate(std::istream& i)
+    {
+        loadbinary(i,nextt);
+        loadtext(i,pd);
+    }
 private:
-    tabstime lastt;
+    tabstime nextt;
     std::poisson_distribution<> pd;
 };
 
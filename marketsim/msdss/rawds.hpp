@@ -9,49 +9,67 @@ namespace marketsim
 class generalrawds : public tdsbase
 {
 public:
-    generalrawds(int eventsperhour, int volumemean) : lastt(0),
+    generalrawds(int eventsperhour, int volumemean) : nextt(std::numeric_limits<tabstime>::max()),
         feventsperhour(eventsperhour), fvolumemean(volumemean),
         pd(volumemean)
-    {}
+    {
+        assert(eventsperhour > 0);
+    }
+    /// called at the arrivals scheduled by generalrawds::nextarrival
     virtual tdsrecord delta(tabstime t, const tmarketdata& md)
     {
         tdsrecord ret = {0,0};
-        if(t > lastt)
+        if(t >= nextt)
         {
-            double lambda = feventsperhour / 3600.0;
-            assert(lambda > 0);
-            double u = uniform();
-            if(-log(u)/lambda < (t-lastt))
+            bool buy = uniform() > 0.5;
+            auto volume = pd(engine());
+            if(volume)
             {
-                bool buy = uniform() > 0.5;
-                auto volume = pd(engine());
-                if(volume)
+                if(buy)
                 {
-                    if(buy)
+                    auto a = md.lastdefineda();
+                    if(a != khundefprice)
                     {
-                        auto a = md.lastdefineda();
-                        if(a != khundefprice)
-                        {
-                            ret = { volume * a,0 };
-                        }
+                        ret = { volume * a,0 };
                     }
-                    else
+                }
+                else
+                {
+                    auto b = md.lastdefinedb();
+                    if(b != klundefprice)
                     {
-                        auto b = md.lastdefinedb();
-                        if(b != klundefprice)
-                        {
-                            ret = { 0,volume };
-                        }
-
+                        ret = { 0,volume };
                     }
+
                 }
             }
-            lastt = t;
         }
         return ret;
     }
+
+    /// the arrivals form a Poisson process, the time to the next one is sampled
+    /// by the inverse of the exponential distribution function
+    virtual tabstime nextarrival(tabstime t)
+    {
+        double lambda = feventsperhour / 3600.0;
+        nextt = t - log(1 - uniform()) / lambda;
+        return nextt;
+    }
+
+    virtual bool savestate(std::ostream& o) const
+    {
+        savebinary(o,nextt);
+        savetext(o,pd);
+        return true;
+    }
+
+    virtual void restorestate(std::istream& i)
+    {
+        loadbinary(i,nextt);
+        loadtext(i,pd);
+    }
 private:
-    tabstime lastt;
+    tabstime nextt;
     std::poisson_distribution<> pd;
     int feventsperhour;
     int fvolumemean;
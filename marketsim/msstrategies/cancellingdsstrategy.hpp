@@ -6,17 +6,22 @@
 namespace marketsim
 {
 
-template <typename T, int meanlife>
-class cancellingstrategy: public T
+/// Strategy \p T whose orders are cancelled after exponentially distributed times
+/// with mean \c meanlife (in seconds) given at runtime.
+template <typename T>
+class tgeneralcancellingstrategy: public T
 {
     bool eraseit(tabstime dt)
     {
-        return -log(T::uniform()) * meanlife < dt;
+        return -log(T::uniform()) * fmeanlife < dt;
     }
 
 
 public:
-    cancellingstrategy() : flastcancellation(0) {}
+    /// constructor, \p args are passed to the constructor of \p T
+    template <typename... Args>
+    tgeneralcancellingstrategy(double meanlife, Args&&... args)
+        : T(std::forward<Args>(args)...), fmeanlife(meanlife), flastcancellation(0) {}
 
     virtual trequest event(const tmarketinfo& info, tabstime t, trequestresult* resultoflast)
     {
@@ -45,10 +50,32 @@ public:
         return r;
     }
 
+    virtual bool savestate(std::ostream& o) const
+    {
+        if(!T::savestate(o))
+            return false;
+        savebinary(o,flastcancellation);
+        return true;
+    }
+
+    virtual void restorestate(std::istream& i)
+    {
+        T::restorestate(i);
+        loadbinary(i,flastcancellation);
+    }
+
 private:
+   double fmeanlife;
    tabstime flastcancellation;
 };
 
+template <typename T, int meanlife>
+class cancellingstrategy: public tgeneralcancellingstrategy<T>
+{
+public:
+    cancellingstrategy() : tgeneralcancellingstrategy<T>(meanlife) {}
+};
+
 } // namespace
 
 #endif // CANCELLINGDSSTRATEGY_HPP
@@ -26,6 +26,8 @@ public:
         setinterval(std::numeric_limits<tabstime>::max());
         return trequest({pp,trequest::teraserequest(false),0});
     }
+
+    virtual bool savestate(std::ostream&) const { return true; }
 private:
     tprice fb;
     tprice fa;
@@ -1,36 +1,44 @@
 #ifndef LUCKOCKSTRATEGY_HPP
 #define LUCKOCKSTRATEGY_HPP
 
+#include <functional>
 #include "marketsim.hpp"
 #include "msstrategies/cancellingdsstrategy.hpp"
 
 namespace marketsim
 {
 
-template <int volume, int eventsperhour, bool random, tprice K(double), tprice L(double) >
-class generalluckockstrategy: public teventdrivenstrategy
+/// Luckock's zero intelligence strategy: puts buy or sell limit orders (with equal
+/// probabilities) with limit prices drawn from quantile functions \c K (buy) and \c L (sell),
+/// at exponentially distributed intervals
+class tluckockstrategy: public teventdrivenstrategy
 {
 public:
-       generalluckockstrategy() : teventdrivenstrategy(0), fpd(volume)
+       /// constructor, \p volume is the (mean, if \p random, then Poisson distributed) volume
+       /// of the orders, \p eventsperhour their mean number per hour
+       tluckockstrategy(std::function<tprice(double)> K, std::function<tprice(double)> L,
+                        int volume, double eventsperhour, bool random)
+           : teventdrivenstrategy(0), fK(K), fL(L), fvolume(volume),
+             feventsperhour(eventsperhour), frandom(random), fpd(volume)
        {
        }
 
        virtual trequest event(const tmarketinfo&, tabstime, trequestresult*)
        {
-           possiblylog("event procedure entered","by generalluckockstrategy");
+           possiblylog("event procedure entered","by luckockstrategy");
 
            bool buy = uniform() < 0.5;
 
            tvolume v;
-           if constexpr(random)
+           if(frandom)
                 v = fpd(engine());
            else
-                v = volume;
+                v = fvolume;
 
            trequest ret;
            if(buy)
            {
-               tprice lprice = K(uniform());
+               tprice lprice = fK(uniform());
                if(market()->islogging())
                {
                    std::ostringstream ls;
@@ -41,7 +49,7 @@ public:
            }
            else
            {
-               tprice lprice = L(uniform());
+               tprice lprice = fL(uniform());
                if(market()->islogging())
                {
                    std::ostringstream ls;
@@ -50,20 +58,80 @@ public:
                }
                ret.addselllimit(lprice,v);
            }
-           double constexpr eventspersec = eventsperhour / 3600.0;
+           double eventspersec = feventsperhour / 3600.0;
            setinterval(-log(uniform()) / eventspersec );
            return ret;
        }
+
+       virtual bool savestate(std::ostream& o) const
+       {
+           savetext(o,fpd);
+           return true;
+       }
+
+       virtual void restorestate(std::istream& i)
+       {
+           loadtext(i,fpd);
+       }
 private:
+       std::function<tprice(double)> fK;
+       std::function<tprice(double)> fL;
+       int fvolume;
+       double feventsperhour;
+       bool frandom;
        std::poisson_distribution<> fpd;
 };
 
+template <int volume, int eventsperhour, bool random, tprice K(double), tprice L(double) >
+class generalluckockstrategy: public tluckockstrategy
+{
+public:
+       generalluckockstrategy() : tluckockstrategy(K, L, volume, eventsperhour, random)
+       {
+       }
+};
+
 template <int maxprice>
 inline tprice uniformquantile(double u) { return static_cast<tprice>(u*maxprice); }
 
+/// parameters of marketsim::tgeneraluniformluckockstrategy
+struct tuniformluckocksetting
+{
+    /// (mean, if \c random) volume of the orders
+    int volume = 10;
+    /// limit prices are uniform on [0, \c maxprice]
+    double maxprice = 200;
+    /// mean number of orders per hour
+    double eventsperhour = 3600;
+    /// if \c true, the volumes are Poisson distributed
+    bool random = false;
+};
+
+/// marketsim::tluckockstrategy with uniform limit prices, parametrized at runtime
+class tgeneraluniformluckockstrategy: public tluckockstrategy
+{
+public:
+       tgeneraluniformluckockstrategy(const tuniformluckocksetting& s)
+           : tluckockstrategy(quantile(s.maxprice), quantile(s.maxprice),
+                              s.volume, s.eventsperhour, s.random)
+       {
+       }
+private:
+       static std::function<tprice(double)> quantile(double maxprice)
+       {
+           return [maxprice](double u) { return static_cast<tprice>(u*maxprice); };
+       }
+};
+
 template <int volume, int maxprice, int eventsperhour, bool random>
-using uniformluckockstrategy=generalluckockstrategy<volume,eventsperhour,random,
-          uniformquantile<maxprice>,uniformquantile<maxprice>>;
+class uniformluckockstrategy: public tgeneraluniformluckockstrategy
+{
+public:
+       uniformluckockstrategy()
+           : tgeneraluniformluckockstrategy({volume,maxprice,eventsperhour,random})
+       {
+       }
+};
 
 template <int volume, int maxprice, int meanlifesec, int eventsperhour, bool random>
 using cancellinguniformluckockstrategy
@@ -86,6 +86,17 @@ public:
            }
            return ret;
        }
+
+       virtual bool savestate(std::ostream& o) const
+       {
+           this->savedsstate(o);
+           return true;
+       }
+
+       virtual void restorestate(std::istream& i)
+       {
+           this->restoredsstate(i);
+       }
 private:
     virtual bool acceptsdemand() const  { return true; }
     virtual bool acceptssupply() const  { return true; }
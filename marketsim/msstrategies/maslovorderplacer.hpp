@@ -52,6 +52,23 @@ public:
            }
            return trequest();
        }
+
+       virtual bool savestate(std::ostream& o) const
+       {
+           savedsstate(o);
+           savebinary(o,flogfair);
+           savebinary(o,flastt);
+           savetext(o,w);
+           return true;
+       }
+
+       virtual void restorestate(std::istream& i)
+       {
+           restoredsstate(i);
+           loadbinary(i,flogfair);
+           loadbinary(i,flastt);
+           loadtext(i,w);
+       }
 private:
     double flogfair;
     double fsigma;
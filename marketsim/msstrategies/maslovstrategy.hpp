@@ -8,12 +8,22 @@
 namespace marketsim
 {
 
-template <int volume, int eventsperhour,int windowsize>
-class generalmaslovstrategy: public teventdrivenstrategy
+/// parameters of marketsim::tgeneralmaslovstrategy
+struct tmaslovsetting
+{
+    /// mean volume of the orders
+    int volume = 10;
+    /// mean number of orders per hour
+    double eventsperhour = 3600;
+    /// width of the window of limit prices around the last defined price
+    double windowsize = 10;
+};
+
+class tgeneralmaslovstrategy: public teventdrivenstrategy
 {
 public:
-       generalmaslovstrategy()
-           : teventdrivenstrategy(0),fpd(volume)
+       tgeneralmaslovstrategy(const tmaslovsetting& s)
+           : teventdrivenstrategy(0),fs(s),fpd(s.volume)
        {
        }
 
@@ -21,7 +31,7 @@ public:
        {
             possiblylog("event procedure entered","by maslovstrategy");
 
-            double constexpr eventspersec = eventsperhour / 3600.0;
+            double eventspersec = fs.eventsperhour / 3600.0;
             setinterval(-log(uniform()) / eventspersec );
 
             double ldp = mi.lastdefinedp();
@@ -29,7 +39,7 @@ public:
             {
 
                 bool buy = uniform() > 0.5;
-                double offset = (uniform() - 0.5) * windowsize;
+                double offset = (uniform() - 0.5) * fs.windowsize;
 
                 tprice lprice = std::max(1,static_cast<tprice>(ldp + offset + 0.5));
 
@@ -62,10 +72,32 @@ public:
            else
                return trequest();
        }
+
+       virtual bool savestate(std::ostream& o) const
+       {
+           savetext(o,fpd);
+           return true;
+       }
+
+       virtual void restorestate(std::istream& i)
+       {
+           loadtext(i,fpd);
+       }
 private:
+       tmaslovsetting fs;
        std::poisson_distribution<> fpd;
 };
 
+template <int volume, int eventsperhour,int windowsize>
+class generalmaslovstrategy: public tgeneralmaslovstrategy
+{
+public:
+       generalmaslovstrategy()
+           : tgeneralmaslovstrategy({volume,eventsperhour,windowsize})
+       {
+       }
+};
+
 using maslovstrategy = generalmaslovstrategy<10,3600,10>;
 
 template <int volume, int eventsperhour, int meanlifesec, int windowsize>
@@ -5,12 +5,26 @@
 
 namespace marketsim {
 
-template <int volume = 1, int eventsperhour = 3600>
-class naivemmstrategy: public teventdrivenstrategy
+/// parameters of marketsim::tgeneralnaivemmstrategy
+struct tnaivemmsetting
+{
+    /// volume of the orders
+    int volume = 1;
+    /// number of events per hour
+    double eventsperhour = 3600;
+};
+
+class tgeneralnaivemmstrategy: public teventdrivenstrategy
 {
 public:
-       naivemmstrategy(double interval=3600.0/ eventsperhour)
-           : teventdrivenstrategy(interval)
+       tgeneralnaivemmstrategy(const tnaivemmsetting& s)
+           : tgeneralnaivemmstrategy(s, 3600.0 / s.eventsperhour)
+       {
+       }
+
+       /// constructor, the events are called every \p interval seconds
+       tgeneralnaivemmstrategy(const tnaivemmsetting& s, double interval)
+           : teventdrivenstrategy(interval), fvolume(s.volume)
        {
        }
 
@@ -47,12 +61,12 @@ public:
                   }
                   tpreorderprofile pp;
 
-                  pp.B.add(tpreorder(proposedb,volume));
-                  pp.A.add(tpreorder(proposeda,volume));
+                  pp.B.add(tpreorder(proposedb,fvolume));
+                  pp.A.add(tpreorder(proposeda,fvolume));
 
                   trequest ord;
-                  ord.addbuylimit(proposedb, volume);
-                  ord.addselllimit(proposeda, volume);
+                  ord.addbuylimit(proposedb, fvolume);
+                  ord.addselllimit(proposeda, fvolume);
                   ord.setconsumption(c);
 
 
@@ -63,6 +77,20 @@ public:
            }
            return trequest();
        }
+
+       virtual bool savestate(std::ostream&) const { return true; }
+private:
+       tvolume fvolume;
+};
+
+template <int volume = 1, int eventsperhour = 3600>
+class naivemmstrategy: public tgeneralnaivemmstrategy
+{
+public:
+       naivemmstrategy(double interval=3600.0/ eventsperhour)
+           : tgeneralnaivemmstrategy({volume,eventsperhour},interval)
+       {
+       }
 };
 
 }
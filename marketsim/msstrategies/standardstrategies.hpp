@@ -0,0 +1,69 @@
+#ifndef STANDARDSTRATEGIES_HPP
+#define STANDARDSTRATEGIES_HPP
+
+#include "marketsim/strategyregistry.hpp"
+#include "msstrategies/maslovstrategy.hpp"
+#include "msstrategies/luckockstrategy.hpp"
+#include "msstrategies/naivemmstrategy.hpp"
+#include "msstrategies/initialstrategy.hpp"
+
+namespace marketsim
+{
+
+/// registry of the strategies parametrized at runtime (the names of the parameters are those
+/// of the template parameters of their template versions)
+inline tstrategyregistry standardstrategies()
+{
+    tstrategyregistry r;
+
+    auto maslov = [](const tstrategyparams& p)
+    {
+        tmaslovsetting s;
+        s.volume = p.at("volume");
+        s.eventsperhour = p.at("eventsperhour");
+        s.windowsize = p.at("windowsize");
+        return s;
+    };
+    tstrategyparams mp = {{"volume",10},{"eventsperhour",3600},{"windowsize",10}};
+    r.add("maslov", mp, [maslov](const tstrategyparams& p)
+        { return new tgeneralmaslovstrategy(maslov(p)); });
+    mp["meanlifesec"] = 360;
+    r.add("cancellingmaslov", mp, [maslov](const tstrategyparams& p)
+        { return new tgeneralcancellingstrategy<tgeneralmaslovstrategy>(p.at("meanlifesec"),maslov(p)); });
+
+    auto luckock = [](const tstrategyparams& p)
+    {
+        tuniformluckocksetting s;
+        s.volume = p.at("volume");
+        s.maxprice = p.at("maxprice");
+        s.eventsperhour = p.at("eventsperhour");
+        s.random = p.at("random") != 0;
+        return s;
+    };
+    tstrategyparams lp = {{"volume",10},{"maxprice",200},{"eventsperhour",3600},{"random",0}};
+    r.add("uniformluckock", lp, [luckock](const tstrategyparams& p)
+        { return new tgeneraluniformluckockstrategy(luckock(p)); });
+    lp["meanlifesec"] = 360;
+    r.add("cancellinguniformluckock", lp, [luckock](const tstrategyparams& p)
+        { return new tgeneralcancellingstrategy<tgeneraluniformluckockstrategy>(p.at("meanlifesec"),
+                                                                              luckock(p)); });
+
+    r.add("naivemm", {{"volume",1},{"eventsperhour",3600}}, [](const tstrategyparams& p)
+    {
+        tnaivemmsetting s;
+        s.volume = p.at("volume");
+        s.eventsperhour = p.at("eventsperhour");
+        return new tgeneralnaivemmstrategy(s);
+    });
+
+    r.add("initial", {{"b",90},{"a",110},{"v",1}}, [](const tstrategyparams& p)
+    {
+        return new generalinitialstrategy(p.at("b"),p.at("a"),p.at("v"));
+    });
+
+    return r;
+}
+
+} // namespace
+
+#endif // STANDARDSTRATEGIES_HPP